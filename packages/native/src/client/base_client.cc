@@ -1,7 +1,13 @@
 #include "base_client.hh"
 #include "napi.h"
 #include "client_action.hh"
+#include "instance_lease.hh"
 #include <spdlog/spdlog.h>
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
 #include "../common/convert.hh"
 #include "../common/logger.hh"
 
@@ -9,23 +15,135 @@ using Logger::logger;
 
 namespace HTML {
   std::shared_ptr<Napi::FunctionReference> errorCallbackRef;
+  // 等待真实id的临时代理，answerId -> 对象
+  static std::unordered_map<int64_t, BaseClient *> pipelinedClients;
+  /**
+   * 流水线读取的属性，(实例id, 属性名) -> 代理
+   *
+   * 重复读取同一属性返回同一个代理，不再发起新的请求：解析前是临时代理，
+   * 解析后answerId为0，代理已换成真实id。失败或代理被回收后移除。只弱引用代理
+   */
+  struct PipelinedProperty {
+    int64_t answerId = 0;
+    int64_t instanceId = 0;
+    Napi::ObjectReference proxy;
+  };
+  static std::map<std::pair<int64_t, std::string>, PipelinedProperty> pipelinedProperties;
+  static PipelinedProperty *findPipelinedProperty(int64_t answerId) {
+    for (auto &item : pipelinedProperties) {
+      if (item.second.answerId == answerId) {
+        return &item.second;
+      }
+    }
+    return nullptr;
+  }
+  static void forgetPipelinedProperty(int64_t answerId) {
+    for (auto it = pipelinedProperties.begin(); it != pipelinedProperties.end(); ++it) {
+      if (it->second.answerId == answerId) {
+        pipelinedProperties.erase(it);
+        return;
+      }
+    }
+  }
+  // 已解析的代理被回收，下次读取重新请求
+  static void forgetResolvedProperty(int64_t instanceId) {
+    for (auto it = pipelinedProperties.begin(); it != pipelinedProperties.end();) {
+      if (it->second.answerId == 0 && it->second.instanceId == instanceId && it->second.proxy.Value().IsEmpty()) {
+        it = pipelinedProperties.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
   
+  BaseClient::~BaseClient() {
+    if (m_instanceId < 0) {
+      pipelinedClients.erase(-m_instanceId);
+      forgetPipelinedProperty(-m_instanceId);
+    } else if (m_instanceId > 0) {
+      // 代理已被回收，最后一个持有者释放后通知服务端
+      Convert::evictInstance(m_instanceId, true);
+      forgetResolvedProperty(m_instanceId);
+      InstanceLease::unhold(m_instanceId);
+    }
+  }
+  void BaseClient::bindInstanceId(int64_t instanceId) {
+    m_instanceId = instanceId;
+    if (instanceId < 0) {
+      pipelinedClients[-instanceId] = this;
+    } else {
+      InstanceLease::hold(instanceId);
+    }
+  }
+  int64_t BaseClient::targetId() const {
+    if (!m_pipelineError.empty()) {
+      throw std::runtime_error(m_pipelineError);
+    }
+    return m_instanceId;
+  }
+  void BaseClient::resolvePipeline(Napi::Env env, int64_t answerId, int64_t instanceId) {
+    // 代理可能已被回收
+    auto target = pipelinedClients.find(answerId);
+    if (target == pipelinedClients.end()) {
+      forgetPipelinedProperty(answerId);
+      return;
+    }
+    target->second->m_instanceId = instanceId;
+    pipelinedClients.erase(target);
+    InstanceLease::imported(instanceId);
+    InstanceLease::hold(instanceId);
+    // 之后读取该属性、或服务端返回同一id时复用这个代理
+    if (auto property = findPipelinedProperty(answerId)) {
+      property->answerId = 0;
+      property->instanceId = instanceId;
+      auto proxy = property->proxy.Value();
+      if (!proxy.IsEmpty()) {
+        Convert::cacheInstance(instanceId, proxy);
+      }
+    }
+  }
+  void BaseClient::rejectPipeline(Napi::Env env, int64_t answerId, const std::string &message) {
+    forgetPipelinedProperty(answerId);
+    auto target = pipelinedClients.find(answerId);
+    if (target == pipelinedClients.end()) {
+      return;
+    }
+    // 临时id随answer一起释放，代理不再可用
+    target->second->m_pipelineError = message.empty() ? "Pipelined property failed" : message;
+    pipelinedClients.erase(target);
+  }
   Napi::Value BaseClient::getInstanceId(const Napi::CallbackInfo &info) {
     return Napi::Number::New(info.Env(), m_instanceId);
   }
   Napi::Value BaseClient::sendToServerSync(const Napi::CallbackInfo &info, const std::string &methodName) {
+    auto env = info.Env();
+    try {
+      return ClientAction::callDynamicSync(env, targetId(), methodName, info);
+    } catch (const std::exception &e) {
+      if (errorCallbackRef && !errorCallbackRef->IsEmpty()) {
+        logger->error("Error in sendToServerSync: {}", e.what());
+        errorCallbackRef->Call({Napi::String::New(env, e.what())});
+      }
+      throw Napi::Error::New(env, e.what());
+    }
+    catch (...) {
+      if (errorCallbackRef && !errorCallbackRef->IsEmpty()) {
+        errorCallbackRef->Call({Napi::String::New(env, "Unknown error occurred")});
+      }
+      throw Napi::Error::New(env, "Unknown error occurred");
+    }
+  }
+  Napi::Value BaseClient::sendToServerAsync(const Napi::CallbackInfo &info, const std::string &methodName) {
     auto env = info.Env();
     nlohmann::json args;
     for (int i = 0; i < info.Length(); i++) {
       args[i] = Convert::convertValue2Json(env, info[i]);
     }
     try {
-      auto result = ClientAction::callDynamicSync(m_instanceId, methodName, args);
-      auto returnValue = result["returnValue"];
-      return Convert::convertJson2Value(env, returnValue);
+      ClientAction::callDynamicAsync(env, targetId(), methodName, args);
+      return env.Undefined();
     } catch (const std::exception &e) {
       if (errorCallbackRef && !errorCallbackRef->IsEmpty()) {
-        logger->error("Error in sendToServerSync: {}", e.what());
         errorCallbackRef->Call({Napi::String::New(env, e.what())});
       }
       throw Napi::Error::New(env, e.what());
@@ -37,14 +155,25 @@ namespace HTML {
       throw Napi::Error::New(env, "Unknown error occurred");
     }
   }
-  Napi::Value BaseClient::sendToServerAsync(const Napi::CallbackInfo &info, const std::string &methodName) {
+  /**
+   * 出错时reject而不是抛出，调用方统一在Promise上处理
+   */
+  static Napi::Value rejected(Napi::Env env, const char *message) {
+    if (errorCallbackRef && !errorCallbackRef->IsEmpty()) {
+      errorCallbackRef->Call({Napi::String::New(env, message)});
+    }
+    auto deferred = Napi::Promise::Deferred::New(env);
+    deferred.Reject(Napi::Error::New(env, message).Value());
+    return deferred.Promise();
+  }
+  Napi::Value BaseClient::sendEventToServer(const Napi::CallbackInfo &info, const std::string &methodName, bool coalesce) {
     auto env = info.Env();
-    nlohmann::json args;
+    nlohmann::json args = nlohmann::json::array();
     for (int i = 0; i < info.Length(); i++) {
       args[i] = Convert::convertValue2Json(env, info[i]);
     }
     try {
-      ClientAction::callDynamicAsync(m_instanceId, methodName, args);
+      ClientAction::callDynamicEventAsync(env, targetId(), methodName, args, coalesce);
       return env.Undefined();
     } catch (const std::exception &e) {
       if (errorCallbackRef && !errorCallbackRef->IsEmpty()) {
@@ -59,6 +188,39 @@ namespace HTML {
       throw Napi::Error::New(env, "Unknown error occurred");
     }
   }
+  Napi::Value BaseClient::sendToServerPromise(const Napi::CallbackInfo &info, const std::string &methodName) {
+    auto env = info.Env();
+    try {
+      nlohmann::json args;
+      for (int i = 0; i < info.Length(); i++) {
+        args[i] = Convert::convertValue2Json(env, info[i]);
+      }
+      return ClientAction::callDynamicPromise(env, targetId(), methodName, args);
+    } catch (const std::exception &e) {
+      logger->error("Error in sendToServerPromise: {}", e.what());
+      return rejected(env, e.what());
+    }
+    catch (...) {
+      return rejected(env, "Unknown error occurred");
+    }
+  }
+  Napi::Value BaseClient::promiseTwin(const Napi::CallbackInfo &info) {
+    return sendToServerPromise(info, static_cast<const char *>(info.Data()));
+  }
+  Napi::Value BaseClient::getPropertyAsync(const Napi::CallbackInfo &info) {
+    auto env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString()) {
+      return rejected(env, "Property name must be a string");
+    }
+    try {
+      return ClientAction::callDynamicPropertyGetPromise(env, targetId(), info[0].As<Napi::String>().Utf8Value());
+    } catch (const std::exception &e) {
+      return rejected(env, e.what());
+    }
+    catch (...) {
+      return rejected(env, "Unknown error occurred");
+    }
+  }
   int64_t BaseClient::sendConstructorToServerSync(const Napi::CallbackInfo &info, const std::string &className) {
     auto env = info.Env();
     nlohmann::json args;
@@ -70,7 +232,9 @@ namespace HTML {
       if (!result.contains("instanceId")) {
         throw Napi::Error::New(env, "No instanceId in result");
       }
-      return result["instanceId"].get<int64_t>();
+      auto instanceId = result["instanceId"].get<int64_t>();
+      InstanceLease::imported(instanceId);
+      return instanceId;
     } catch (const std::exception &e) {
       logger->error("Error in sendConstructorToServerSync: {}", e.what());
       if (errorCallbackRef && !errorCallbackRef->IsEmpty()) {
@@ -87,12 +251,33 @@ namespace HTML {
       throw Napi::Error::New(env, "Unknown error occurred");
     }
   }
+  int64_t BaseClient::sendConstructorToServerAsync(const Napi::CallbackInfo &info, const std::string &className) {
+    auto env = info.Env();
+    nlohmann::json args;
+    for (int i = 0; i < info.Length(); i++) {
+      args[i] = Convert::convertValue2Json(env, info[i]);
+    }
+    try {
+      auto instanceId = ClientAction::allocateInstanceId();
+      ClientAction::callConstructorBindAsync(env, className, instanceId, args);
+      InstanceLease::imported(instanceId);
+      return instanceId;
+    } catch (const std::exception &e) {
+      logger->error("Error in sendConstructorToServerAsync: {}", e.what());
+      if (errorCallbackRef && !errorCallbackRef->IsEmpty()) {
+        errorCallbackRef->Call({Napi::String::New(env, e.what())});
+      }
+      throw Napi::Error::New(env, e.what());
+    }
+  }
   void BaseClient::setProperty(const Napi::CallbackInfo &info, const std::string &propertyName) {
     auto env = info.Env();
     nlohmann::json args;
     args[0] = Convert::convertValue2Json(env, info[0]);
     try {
-      auto result = ClientAction::callDynamicPropertySetSync(m_instanceId, propertyName, args);
+      // 写后不等待，失败经errorCallbackRef异步报告
+      ClientAction::callDynamicPropertySetAsync(env, targetId(), propertyName, args);
+      ClientAction::evictCachedProperty(targetId(), propertyName);
     } catch (const std::exception &e) {
       if (errorCallbackRef && !errorCallbackRef->IsEmpty()) {
         errorCallbackRef->Call({Napi::String::New(env, e.what())});
@@ -106,14 +291,31 @@ namespace HTML {
       throw Napi::Error::New(env, "Unknown error occurred");
     }
   }
+  void BaseClient::setPropertyCoalesced(const Napi::CallbackInfo &info, const std::string &propertyName) {
+    auto env = info.Env();
+    auto value = Convert::convertValue2Json(env, info[0]);
+    try {
+      ClientAction::callDynamicPropertySetCoalesced(env, targetId(), propertyName, value);
+      ClientAction::evictCachedProperty(targetId(), propertyName);
+    } catch (const std::exception &e) {
+      if (errorCallbackRef && !errorCallbackRef->IsEmpty()) {
+        errorCallbackRef->Call({Napi::String::New(env, e.what())});
+      }
+      throw Napi::Error::New(env, e.what());
+    }
+  }
   Napi::Value BaseClient::getProperty(const Napi::CallbackInfo &info, const std::string &propertyName) {
     auto env = info.Env();
     nlohmann::json args;
     args[0] = Convert::convertValue2Json(env, info[0]);
     try {
-      auto result = ClientAction::callDynamicPropertyGetSync(m_instanceId, propertyName);
-      auto returnValue = result["returnValue"];
-      return Convert::convertJson2Value(env, returnValue);
+      if (!m_prefetch.empty() && std::find(m_prefetch.begin(), m_prefetch.end(), propertyName) != m_prefetch.end()) {
+        auto names = std::move(m_prefetch);
+        m_prefetch.clear();
+        auto values = ClientAction::callDynamicPropertiesGetSync(targetId(), names);
+        return Convert::convertJson2Value(env, values[propertyName]);
+      }
+      return ClientAction::callDynamicPropertyGetCached(env, targetId(), propertyName);
     } catch (const std::exception &e) {
       if (errorCallbackRef && !errorCallbackRef->IsEmpty()) {
         errorCallbackRef->Call({Napi::String::New(env, e.what())});
@@ -128,4 +330,61 @@ namespace HTML {
     }
   }
 
+  void BaseClient::prefetchProperties(std::initializer_list<const char *> names) {
+    m_prefetch.assign(names.begin(), names.end());
+  }
+
+  Napi::Value BaseClient::getProperties(const Napi::CallbackInfo &info) {
+    auto env = info.Env();
+    if (info.Length() < 1 || !info[0].IsArray()) {
+      throw Napi::TypeError::New(env, "getProperties: expected an array of property names");
+    }
+    auto list = info[0].As<Napi::Array>();
+    std::vector<std::string> names;
+    names.reserve(list.Length());
+    for (uint32_t i = 0; i < list.Length(); i++) {
+      names.push_back(list.Get(i).ToString().Utf8Value());
+    }
+    try {
+      auto values = ClientAction::callDynamicPropertiesGetSync(targetId(), names);
+      return Convert::convertJson2Value(env, values);
+    } catch (const std::exception &e) {
+      if (errorCallbackRef && !errorCallbackRef->IsEmpty()) {
+        errorCallbackRef->Call({Napi::String::New(env, e.what())});
+      }
+      throw Napi::Error::New(env, e.what());
+    }
+  }
+
+  Napi::Value BaseClient::getPipelinedProperty(const Napi::CallbackInfo &info, const std::string &propertyName, const std::string &instanceType) {
+    auto env = info.Env();
+    int64_t answerId = 0;
+    try {
+      auto cached = pipelinedProperties.find(std::make_pair(targetId(), propertyName));
+      if (cached != pipelinedProperties.end()) {
+        auto proxy = cached->second.proxy.Value();
+        if (!proxy.IsEmpty()) {
+          return proxy;
+        }
+        pipelinedProperties.erase(cached);
+      }
+      answerId = ClientAction::callDynamicPropertyGetPipelined(env, targetId(), propertyName,
+                                                               &BaseClient::resolvePipeline, &BaseClient::rejectPipeline);
+    } catch (const std::exception &e) {
+      if (errorCallbackRef && !errorCallbackRef->IsEmpty()) {
+        errorCallbackRef->Call({Napi::String::New(env, e.what())});
+      }
+      throw Napi::Error::New(env, e.what());
+    }
+    auto proxy = Convert::createInstance(env, instanceType, -answerId);
+    if (proxy.IsUndefined()) {
+      logger->error("Pipelined instance type not registered: {}", instanceType);
+      return getProperty(info, propertyName);
+    }
+    auto &entry = pipelinedProperties[std::make_pair(m_instanceId, propertyName)];
+    entry.answerId = answerId;
+    entry.proxy = Napi::Weak(proxy.As<Napi::Object>());
+    return proxy;
+  }
+
 } // namespace SkylineShell
\ No newline at end of file
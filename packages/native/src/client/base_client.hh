@@ -1,14 +1,44 @@
 #ifndef __BASE_CLIENT_HH__
 #define __BASE_CLIENT_HH__
 #include <napi.h>
+#include <deque>
+#include <initializer_list>
+#include <string>
+#include <vector>
 
 namespace HTML {
 extern std::shared_ptr<Napi::FunctionReference> errorCallbackRef;
 class BaseClient {
 public:
+  ~BaseClient();
   Napi::Value getInstanceId(const Napi::CallbackInfo &info);
+  /**
+   * xxxAsync方法的实现，方法名由注册时的data传入
+   */
+  Napi::Value promiseTwin(const Napi::CallbackInfo &info);
+  /**
+   * getPropertyAsync(name)
+   */
+  Napi::Value getPropertyAsync(const Napi::CallbackInfo &info);
+  /**
+   * getProperties([names])，一次往返读取多个属性，返回{name: value}
+   */
+  Napi::Value getProperties(const Napi::CallbackInfo &info);
 protected:
-  int64_t m_instanceId;
+  // 负数表示流水线结果的临时代理，值为-answerId
+  int64_t m_instanceId = 0;
+  /**
+   * 构造时记录实例id，临时代理登记后等待真实id
+   */
+  void bindInstanceId(int64_t instanceId);
+  /**
+   * 请求使用的实例id；流水线读取失败的临时代理抛出该次读取的错误
+   */
+  int64_t targetId() const;
+  /**
+   * 登记一组常用属性，首次读取其中任一属性时一次取回全部
+   */
+  void prefetchProperties(std::initializer_list<const char *> names);
   /**
    * 与服务器通信
    * 
@@ -21,24 +51,93 @@ protected:
    * 异步方法,不关心回复
    */
   Napi::Value sendToServerAsync(const Napi::CallbackInfo &info, const std::string &methodName);
+  /**
+   * 与服务器通信
+   * 
+   * 异步方法,返回Promise,resolve为服务端的返回值
+   */
+  Napi::Value sendToServerPromise(const Napi::CallbackInfo &info, const std::string &methodName);
+  /**
+   * 与服务器通信
+   * 
+   * 异步方法,用于输入事件；coalesce为true时按帧批量发送,连续的同名事件只发送最后一个,
+   * 否则在当前任务结束时发送
+   */
+  Napi::Value sendEventToServer(const Napi::CallbackInfo &info, const std::string &methodName, bool coalesce);
   /**
    * 与服务器通信
    * 
    * 同步方法,用于构造函数
    */
   int64_t sendConstructorToServerSync(const Napi::CallbackInfo &info, const std::string &className);
+  /**
+   * 与服务器通信
+   * 
+   * 异步方法,用于构造函数,实例id由客户端分配,无需等待服务器
+   */
+  int64_t sendConstructorToServerAsync(const Napi::CallbackInfo &info, const std::string &className);
 
   /**
    * 获取property
    */
   void setProperty(const Napi::CallbackInfo &info, const std::string &propertyName);
+  /**
+   * 设置property，按帧合并，只发送每帧最后一次写入
+   */
+  void setPropertyCoalesced(const Napi::CallbackInfo &info, const std::string &propertyName);
   /**
    * 设置property
    */
   Napi::Value getProperty(const Napi::CallbackInfo &info, const std::string &propertyName);
+  /**
+   * 获取实例类型的property，不等待服务端
+   * 
+   * 立即返回instanceType类型的临时代理，代理上的调用由服务端在同一顺序中解析，
+   * 如 controller.webview.style.display = 'block' 只需一次往返
+   */
+  Napi::Value getPipelinedProperty(const Napi::CallbackInfo &info, const std::string &propertyName, const std::string &instanceType);
+
+private:
+  // 尚未取回的预取属性
+  std::vector<std::string> m_prefetch;
+  // 流水线读取失败时的错误，之后该代理上的调用都以此报错
+  std::string m_pipelineError;
+  static void resolvePipeline(Napi::Env env, int64_t answerId, int64_t instanceId);
+  static void rejectPipeline(Napi::Env env, int64_t answerId, const std::string &message);
   
 };
 
+/**
+ * 远程方法表的一项：JS方法名、同步实现和属性
+ */
+template<typename T>
+struct RemoteMethod {
+  const char *name;
+  Napi::Value (T::*method)(const Napi::CallbackInfo &);
+  napi_property_attributes attributes = napi_default;
+};
+
+/**
+ * 按同一张表注册同步方法和返回Promise的xxxAsync版本
+ *
+ * 多个请求可以同时在途，不必逐个等待往返；表中新增的方法自动带有Async版本
+ */
+template<typename T>
+void AddRemoteMethods(std::vector<Napi::ClassPropertyDescriptor<T>> &methods, std::initializer_list<RemoteMethod<T>> table) {
+  // DefineClass之后仍会通过data读取方法名，需要一直有效
+  static std::deque<std::string> twinNames;
+  for (const auto &entry : table) {
+    methods.push_back(Napi::InstanceWrap<T>::InstanceMethod(entry.name, entry.method, entry.attributes));
+  }
+  for (const auto &entry : table) {
+    twinNames.push_back(std::string(entry.name) + "Async");
+    methods.push_back(Napi::InstanceWrap<T>::InstanceMethod(
+      twinNames.back().c_str(),
+      static_cast<Napi::Value (T::*)(const Napi::CallbackInfo &)>(&BaseClient::promiseTwin),
+      napi_default, const_cast<char *>(entry.name)));
+  }
+}
+
 } // namespace HTML
 
 #endif
\ No newline at end of file
@@ -3,19 +3,41 @@
 
 #include <cstdint>
 #include <string>
+#include <nlohmann/json.hpp>
+#include "../common/buffer_pool.hh"
+#include "../common/frame.hh"
+#include "../common/frame_compression.hh"
 namespace SkylineClient {
 
+/**
+ * Controller.connect的options
+ */
+struct Options {
+    // 首选编码，服务端不支持时退回JSON
+    Frame::Codec codec = Frame::Codec::MsgPack;
+    // 同机时握手后改走共享内存
+    bool sharedMemory = false;
+    // 超过该长度的payload压缩发送，0表示关闭
+    std::size_t compressThreshold = Frame::Compressor::thresholdFromEnv();
+};
+
 class Client {
 public:
     virtual void Init(std::string &address, int port) = 0;
 
     virtual bool IsConnected() = 0;
+
+    // Codec selected during the handshake
+    virtual Frame::Codec codec() = 0;
+
+    // Per-connection transport statistics
+    virtual nlohmann::json stats() = 0;
     
     // Send a message to the shared memory
-    virtual void sendMessage(std::string &&message, std::int64_t messageId = 0) = 0;
+    virtual void sendMessage(std::string &&message, std::int64_t messageId = 0, std::uint8_t flags = 0) = 0;
 
     // Receive a message from the shared memory
-    virtual std::string receiveMessage(std::int64_t *messageId = nullptr) = 0;
+    virtual Frame::Buffer receiveMessage(std::int64_t *messageId = nullptr, std::uint8_t *flags = nullptr) = 0;
 
 };
 }
@@ -8,66 +8,467 @@
 #include <future>
 #include <condition_variable>
 #include <algorithm>
+#include <atomic>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <map>
+#include <type_traits>
 #include "client_action.hh"
 #include "../common/logger.hh"
 #include "../common/convert.hh"
+#include "../common/frame.hh"
+#include "../common/json_encoder.hh"
+#include "../common/msgpack_encoder.hh"
+#include "../common/frame_message.hh"
+#include "../common/lane_stats.hh"
 #include "client_socket.hh"
+#include "client_unix_socket.hh"
+#include "result_memo.hh"
+#include "method_table.hh"
+#include "instance_lease.hh"
 
 using Logger::logger;
 
 namespace ClientAction {
     struct CallbackQueueItem {
-        nlohmann::json payload;
+        Frame::Message message;
         int64_t messageId;
     };
     static std::mutex socketRequestMutex;  // Add mutex for thread synchronization
     static std::condition_variable socketEventCv;
-    static std::unordered_map<int64_t, std::shared_ptr<std::promise<std::string>>> socketRequest;
+    static std::unordered_map<int64_t, std::shared_ptr<std::promise<Frame::Message>>> socketRequest;
     static std::queue<CallbackQueueItem> callbackQueue;
     static std::mutex callbackQueueMutex;
     static int64_t requestId = 1;
     static std::shared_ptr<SkylineClient::Client> client;
+    // 同步请求按通道统计在途数量与往返耗时
+    static Frame::LaneStats laneStats;
+    // 待合并发送的异步调用，只在JS主线程访问
+    static std::vector<nlohmann::json> pendingAsync;
+    static bool flushScheduled = false;
+    static std::shared_ptr<Napi::FunctionReference> flushAsyncRef;
+    // 返回Promise的请求，等待响应期间不阻塞JS主线程
+    struct PendingPromise {
+        // 响应中需要转换为JS值的部分
+        std::string pointer;
+        std::function<void(Napi::Env, Napi::Value)> resolve;
+        // 参数为Error对象
+        std::function<void(Napi::Env, Napi::Value)> reject;
+        Frame::Lane lane;
+        std::chrono::steady_clock::time_point start;
+    };
+    struct PromiseResult {
+        int64_t messageId = 0;
+        Frame::Message message;
+        // 连接断开，拒绝所有未完成的Promise
+        bool disconnected = false;
+    };
+    // 只在JS主线程访问
+    static std::unordered_map<int64_t, PendingPromise> pendingPromises;
+    // 接收线程据此区分响应由Promise还是同步调用等待，受socketRequestMutex保护
+    static std::unordered_set<int64_t> promiseRequests;
+    static Napi::ThreadSafeFunction promiseTsfn;
+    static std::atomic<bool> promiseTsfnReady{false};
+    // 流水线请求的结果编号，服务端按此暂存结果，只在JS主线程访问
+    static int64_t pipelineAnswerId = 1;
+    static int64_t clientInstanceId = kClientInstanceIdBase;
+    // 服务端允许缓存的属性值，instanceId -> 属性名 -> 值；invalidate在接收线程处理
+    static std::mutex propertyCacheMutex;
+    static std::unordered_map<int64_t, std::unordered_map<std::string, nlohmann::json>> propertyCache;
+    // 每次失效加一，读取期间发生失效时不写入缓存
+    static uint64_t propertyCacheEpoch = 0;
+    static std::atomic<uint64_t> propertyCacheHits{0};
+    static std::atomic<uint64_t> propertyCacheMisses{0};
+    static std::atomic<uint64_t> propertyCacheInvalidations{0};
+    // 单向请求在服务端失败时交给JS主线程处理
+    static std::function<void(Napi::Env, const std::string &)> asyncErrorHandler;
+    static Napi::ThreadSafeFunction asyncErrorTsfn;
+    static std::atomic<bool> asyncErrorTsfnReady{false};
+    // 按帧合并的属性写入，只保留每个(实例, 属性)最新的值，只在JS主线程访问
+    static std::map<std::pair<int64_t, std::string>, nlohmann::json> dirtyProperties;
+    // 首次写入的顺序
+    static std::vector<std::pair<int64_t, std::string>> dirtyOrder;
+    static bool frameFlushScheduled = false;
+    static std::shared_ptr<Napi::FunctionReference> flushFrameRef;
+    static constexpr int kFrameIntervalMs = 16;
+    // 没有其他请求时，排队的实例释放最多等待的时间
+    static std::shared_ptr<Napi::FunctionReference> releaseTimerRef;
+    static constexpr int kReleaseIntervalMs = 1000;
+    static void queueCoalesced();
+    static void flushCoalesced();
+    // pendingAsync中可被后续同类输入事件覆盖的位置，只有队尾的事件可以合并
+    static std::size_t mergeableEvent = SIZE_MAX;
+    static uint64_t inputEventsQueued = 0;
+    static uint64_t inputEventsCoalesced = 0;
+    // 直接编码同步调用的报文缓冲区，编码中读取JS属性可能重入，重入时使用临时的编码器
+    static Frame::JsonEncoder requestEncoder;
+    static bool requestEncoderBusy = false;
+    static Frame::MsgPackEncoder msgpackRequestEncoder;
+    static bool msgpackRequestEncoderBusy = false;
+
+    /**
+     * 服务端删除的实例不再缓存；回收的代理对应的实例排在batch末尾释放，
+     * 之前排队的调用仍可引用它们
+     */
+    static void collectInstances(std::vector<nlohmann::json> &batch) {
+        for (auto instanceId : InstanceLease::takeDropped()) {
+            Convert::evictInstance(instanceId);
+        }
+        std::vector<int64_t> released;
+        auto releases = InstanceLease::takeReleases(released);
+        if (releases.is_null()) {
+            return;
+        }
+        for (auto instanceId : released) {
+            ResultMemo::invalidateAfter(ResultMemo::instanceTarget(instanceId), "release");
+        }
+        {
+            std::lock_guard<std::mutex> lock(propertyCacheMutex);
+            for (auto instanceId : released) {
+                propertyCache.erase(instanceId);
+            }
+        }
+        batch.push_back(std::move(releases));
+    }
+
+    void flushAsync() {
+        flushScheduled = false;
+        mergeableEvent = SIZE_MAX;
+        if (!client || (pendingAsync.empty() && !InstanceLease::hasReleases())) {
+            return;
+        }
+        std::vector<nlohmann::json> batch;
+        batch.swap(pendingAsync);
+        collectInstances(batch);
+        for (auto &item : batch) {
+            MethodTable::compact(item);
+        }
+        if (auto definitions = MethodTable::takeDefinitions(); !definitions.is_null()) {
+            batch.insert(batch.begin(), std::move(definitions));
+        }
+        auto codec = client->codec();
+        uint8_t flags = 0;
+        if (batch.size() == 1) {
+            auto payload = Frame::encode(batch.front(), codec, flags);
+            client->sendMessage(std::move(payload), 0, flags);
+            return;
+        }
+        logger->debug("Flush {} async calls as one batch", batch.size());
+        auto payload = Frame::encode(nlohmann::json(std::move(batch)), codec, flags);
+        client->sendMessage(std::move(payload), 0, flags | Frame::kBatchFlag);
+    }
+
+    /**
+     * 代理在GC中回收，之后可能一直没有其他请求；定时发出排队的释放，定时器不阻止进程退出
+     */
+    void startReleaseTimer(Napi::Env env) {
+        if (releaseTimerRef) {
+            return;
+        }
+        auto setInterval = env.Global().Get("setInterval");
+        if (!setInterval.IsFunction()) {
+            return;
+        }
+        auto flush = Napi::Function::New(env, [](const Napi::CallbackInfo &info) {
+            if (!InstanceLease::hasReleases()) {
+                return;
+            }
+            try {
+                flushAsync();
+            } catch (const std::exception &e) {
+                logger->error("Flush instance releases error: {}", e.what());
+            }
+        }, "flushReleases");
+        releaseTimerRef = std::make_shared<Napi::FunctionReference>(Napi::Persistent(flush));
+        auto timer = setInterval.As<Napi::Function>().Call({flush, Napi::Number::New(env, kReleaseIntervalMs)});
+        if (timer.IsObject()) {
+            auto unref = timer.As<Napi::Object>().Get("unref");
+            if (unref.IsFunction()) {
+                unref.As<Napi::Function>().Call(timer, {});
+            }
+        }
+    }
+
+    /**
+     * 在当前JS任务结束时（微任务）发送缓存的异步调用
+     */
+    static void scheduleFlush(Napi::Env env) {
+        if (flushScheduled) {
+            return;
+        }
+        if (!flushAsyncRef) {
+            flushAsyncRef = std::make_shared<Napi::FunctionReference>(Napi::Persistent(
+                Napi::Function::New(env, [](const Napi::CallbackInfo &info) {
+                    try {
+                        flushAsync();
+                    } catch (const std::exception &e) {
+                        logger->error("Flush async calls error: {}", e.what());
+                    }
+                }, "flushAsync")));
+        }
+        auto queueMicrotask = env.Global().Get("queueMicrotask");
+        if (!queueMicrotask.IsFunction()) {
+            flushAsync();
+            return;
+        }
+        queueMicrotask.As<Napi::Function>().Call({flushAsyncRef->Value()});
+        flushScheduled = true;
+    }
+
+    /**
+     * 按握手协商的编码发送
+     *
+     * 先发出按帧合并的属性写入和缓存的异步调用，保证之后的读取能看到写入的值
+     */
+    static void sendPayload(std::string &&payload, int64_t messageId, uint8_t flags) {
+        flushCoalesced();
+        flushAsync();
+        client->sendMessage(std::move(payload), messageId, flags);
+    }
+    static void sendPayload(const nlohmann::json &data, int64_t messageId) {
+        uint8_t flags = 0;
+        auto payload = Frame::encode(data, client->codec(), flags);
+        sendPayload(std::move(payload), messageId, flags);
+    }
+
+    /**
+     * 编码需要回复的请求，类型和方法名替换为编号
+     *
+     * 先发出排队中的调用；本次新分配的编号定义单独成帧，先于请求发出。flags为该帧的flags
+     */
+    static void sendDefinitions() {
+        if (auto definitions = MethodTable::takeDefinitions(); !definitions.is_null()) {
+            auto codec = client->codec();
+            client->sendMessage(Frame::encode(definitions, codec), 0, Frame::makeFlags(codec));
+        }
+    }
+    static std::string encodeRequest(nlohmann::json &data, uint8_t &flags) {
+        flushCoalesced();
+        flushAsync();
+        MethodTable::compact(data);
+        sendDefinitions();
+        return Frame::encode(data, client->codec(), flags);
+    }
 
-    void processMessage(const std::string &message, int64_t messageId = 0) {
-        logger->debug("Received message length: {}", message.size());
-        if (message.empty()) {
+    /**
+     * 回调参数data.args直接转为JS值
+     */
+    static std::vector<Napi::Value> callbackArgs(Napi::Env env, Frame::Message &message) {
+        std::vector<Napi::Value> argsVec;
+        auto args = Convert::convertMessage2Value(env, message, "/data/args");
+        if (args.IsArray()) {
+            auto arr = args.As<Napi::Array>();
+            argsVec.reserve(arr.Length());
+            for (uint32_t i = 0; i < arr.Length(); i++) {
+                argsVec.push_back(arr.Get(i));
+            }
+        }
+        return argsVec;
+    }
+
+    static int64_t nextRequestId() {
+        if (requestId >= Frame::kMaxMessageId - 1) {
+            requestId = 1;
+        }
+        auto id = requestId;
+        requestId += 2;
+        return id;
+    }
+
+    /**
+     * 在JS主线程完成Promise
+     */
+    static void settlePromise(Napi::Env env, Napi::Function, PromiseResult *data) {
+        std::unique_ptr<PromiseResult> result(data);
+        if (env == nullptr) {
+            return;
+        }
+        Napi::HandleScope scope(env);
+        if (result->disconnected) {
+            auto pending = std::move(pendingPromises);
+            pendingPromises.clear();
+            for (auto &item : pending) {
+                item.second.reject(env, Napi::Error::New(env, "Connection to server lost").Value());
+            }
+            if (!pending.empty()) {
+                promiseTsfn.Unref(env);
+            }
+            return;
+        }
+        auto target = pendingPromises.find(result->messageId);
+        if (target == pendingPromises.end()) {
+            logger->error("promise messageId not found: {}", result->messageId);
+            return;
+        }
+        auto pending = std::move(target->second);
+        pendingPromises.erase(target);
+        if (pendingPromises.empty()) {
+            promiseTsfn.Unref(env);
+        }
+        laneStats.end(pending.lane, std::chrono::steady_clock::now() - pending.start);
+        Napi::Value value;
+        try {
+            const auto &route = result->message.route();
+            if (!route.isObject) {
+                throw std::runtime_error("Server response is empty");
+            }
+            if (route.hasError) {
+                throw std::runtime_error("Server response error: " + route.error);
+            }
+            value = Convert::convertMessage2Value(env, result->message, pending.pointer);
+        } catch (const Napi::Error &e) {
+            pending.reject(env, e.Value());
+            return;
+        } catch (const std::exception &e) {
+            pending.reject(env, Napi::Error::New(env, e.what()).Value());
+            return;
+        }
+        pending.resolve(env, value);
+    }
+
+    void processMessage(Frame::Buffer &&payload, int64_t messageId = 0, uint8_t flags = 0) {
+        logger->debug("Received message length: {}", payload.size());
+        if (payload.empty()) {
             logger->error("Received message is empty!");
             return;
         }
+        Frame::Message message(std::move(payload), Frame::codecOf(flags), flags);
 
         if (messageId > 0 && (messageId & 1LL) == 1LL) {
-            std::shared_ptr<std::promise<std::string>> promise;
+            std::shared_ptr<std::promise<Frame::Message>> promise;
+            bool promised = false;
             {
                 std::lock_guard<std::mutex> lock(socketRequestMutex);
-                if (auto target = socketRequest.find(messageId); target != socketRequest.end()) {
+                if (promiseRequests.erase(messageId) > 0) {
+                    promised = true;
+                } else if (auto target = socketRequest.find(messageId); target != socketRequest.end()) {
                     promise = std::move(target->second);
                     socketRequest.erase(target);
                 } else {
                     logger->error("response messageId not found: {}", messageId);
                 }
             }
+            if (promised) {
+                // 与同步请求一样在接收线程读出error字段，转换为JS值留给主线程
+                try {
+                    message.route();
+                } catch (...) {
+                    // 主线程再次读取时会拒绝该Promise
+                }
+                promiseTsfn.NonBlockingCall(new PromiseResult{messageId, std::move(message), false}, settlePromise);
+                return;
+            }
             if (promise) {
-                promise->set_value(message);
+                // 在接收线程读出error字段（二进制编码时整体解码），result在主线程按需物化
+                try {
+                    message.route();
+                    promise->set_value(std::move(message));
+                } catch (...) {
+                    promise->set_exception(std::current_exception());
+                }
                 socketEventCv.notify_all();
             }
             return;
         }
 
-        nlohmann::json json = nlohmann::json::parse(message);
-        if (!json["type"].empty() && json["type"].get<std::string>() == "emitCallback") {
-                auto callbackId = json["callbackId"].get<int64_t>();
-                auto block = json["data"]["block"];
+        // 只读取分发需要的字段，参数在调用回调时才转换
+        const auto route = message.route();
+        if (route.type == "invalidate") {
+            // 服务端属性发生变化，property缺省时整个实例失效
+            auto data = message.json("/data");
+            std::lock_guard<std::mutex> lock(propertyCacheMutex);
+            propertyCacheEpoch++;
+            propertyCacheInvalidations.fetch_add(1, std::memory_order_relaxed);
+            if (!data.is_object() || !data["instanceId"].is_number_integer()) {
+                return;
+            }
+            auto target = propertyCache.find(data["instanceId"].get<int64_t>());
+            if (target == propertyCache.end()) {
+                return;
+            }
+            if (data["property"].is_string()) {
+                target->second.erase(data["property"].get<std::string>());
+            } else {
+                propertyCache.erase(target);
+            }
+            return;
+        }
+        if (route.type == "dropInstances") {
+            // 服务端已删除这些实例，客户端的代理缓存在JS主线程下次发送前移除
+            auto data = message.json("/data/instanceIds");
+            if (!data.is_array()) {
+                return;
+            }
+            std::vector<int64_t> instanceIds;
+            for (const auto &item : data) {
+                if (item.is_number_integer()) {
+                    instanceIds.push_back(item.get<int64_t>());
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lock(propertyCacheMutex);
+                propertyCacheEpoch++;
+                for (auto instanceId : instanceIds) {
+                    propertyCache.erase(instanceId);
+                }
+            }
+            InstanceLease::dropped(instanceIds);
+            return;
+        }
+        if (route.type == "asyncError") {
+            // 单向请求（异步调用、属性设置）失败，可能只执行了一部分，该实例已缓存的属性值都不再可信。
+            // 发送时已丢弃过一次，这期间的读取可能又缓存了失败前的值
+            auto data = message.json("/data");
+            auto error = data.is_object() && data["error"].is_string() ? data["error"].get<std::string>() : std::string("Unknown error occurred");
+            logger->error("Async request failed on server: {}", error);
+            if (data.is_object() && data["instanceId"].is_number_integer()) {
+                std::lock_guard<std::mutex> lock(propertyCacheMutex);
+                propertyCacheEpoch++;
+                propertyCache.erase(data["instanceId"].get<int64_t>());
+            }
+            if (asyncErrorTsfnReady.load()) {
+                asyncErrorTsfn.NonBlockingCall(new std::string(error), [](Napi::Env env, Napi::Function, std::string *data) {
+                    std::unique_ptr<std::string> error(data);
+                    if (env != nullptr && asyncErrorHandler) {
+                        Napi::HandleScope scope(env);
+                        asyncErrorHandler(env, *error);
+                    }
+                });
+            }
+            return;
+        }
+        if (route.type == "unregister") {
+            // 服务端回收了回调代理，经该回调的tsfn回到JS主线程释放，排在已派发的回调之后
+            auto callbackId = route.callbackId;
+            auto count = message.json("/data/count");
+            auto ptr = Convert::find_callback(callbackId);
+            if (ptr != nullptr) {
+                ptr->tsfn.NonBlockingCall(new int64_t(count.is_number_integer() ? count.get<int64_t>() : 1),
+                    [callbackId](Napi::Env env, Napi::Function, int64_t *data) {
+                        std::unique_ptr<int64_t> count(data);
+                        if (env != nullptr) {
+                            Convert::releaseCallback(callbackId, *count);
+                        }
+                    });
+            }
+            return;
+        }
+        if (route.type == "emitCallback") {
+                auto callbackId = route.callbackId;
+                auto block = route.block;
                 {
                     // 直接丢进队列，可能send那边会处理，也可能是下面的tsfn处理
                     std::lock_guard<std::mutex> lock(callbackQueueMutex);
                     logger->debug("Push callback msg to queue...");
-                    callbackQueue.push(CallbackQueueItem{std::move(json), messageId});
+                    callbackQueue.push(CallbackQueueItem{std::move(message), messageId});
                 }
                 socketEventCv.notify_all();
                 auto ptr = Convert::find_callback(callbackId);
                 if (ptr != nullptr) {
                     logger->debug("callbackId found: {}", callbackId);
-                    if (block.is_boolean() && block.get<bool>() == false) {
+                    if (!block) {
                         logger->debug("Block value: false...");
                         ptr->tsfn.NonBlockingCall([](Napi::Env env, Napi::Function jsCallback) {
                             logger->debug("NonBlockingCall...");
@@ -82,16 +483,8 @@ namespace ClientAction {
                                 callbackQueue.pop();
                                 logger->debug("Pop msg from queue...");
                             }
-                            auto &json = item.payload;
-                            auto args = json["data"]["args"];
-                            auto callbackId = json["callbackId"].get<int64_t>();
                             Napi::HandleScope scope(env);
-                            std::vector<Napi::Value> argsVec;
-                            argsVec.reserve(args.size());
-                            
-                            for (auto& arg : args) {
-                                argsVec.push_back(Convert::convertJson2Value(env, arg));
-                            }
+                            auto argsVec = callbackArgs(env, item.message);
                             logger->debug("call callback function...");
                             auto resultValue = jsCallback.Call(argsVec);
                             logger->debug("call callback function end...");
@@ -99,10 +492,10 @@ namespace ClientAction {
                             auto resultJson = Convert::convertValue2Json(env, resultValue);
                             if (item.messageId > 0) {
                                 logger->info("reply callback...");
-                                client->sendMessage(nlohmann::json{
+                                sendPayload(nlohmann::json{
                                     {"type", "callbackReply"},
                                     {"result", std::move(resultJson)},
-                                }.dump(), item.messageId);
+                                }, item.messageId);
                             }
                         });
                     } else {
@@ -120,16 +513,8 @@ namespace ClientAction {
                                 callbackQueue.pop();
                                 logger->debug("Pop msg from queue...");
                             }
-                            auto &json = item.payload;
-                            auto args = json["data"]["args"];
-                            auto callbackId = json["callbackId"].get<int64_t>();
                             Napi::HandleScope scope(env);
-                            std::vector<Napi::Value> argsVec;
-                            argsVec.reserve(args.size());
-                            
-                            for (auto& arg : args) {
-                                argsVec.push_back(Convert::convertJson2Value(env, arg));
-                            }
+                            auto argsVec = callbackArgs(env, item.message);
                             logger->debug("Call callback function...");
                             auto resultValue = jsCallback.Call(argsVec);
                             logger->debug("Call callback function end...");
@@ -137,10 +522,10 @@ namespace ClientAction {
                             auto resultJson = Convert::convertValue2Json(env, resultValue);
                             if (item.messageId > 0) {
                                 logger->debug("reply callback...");
-                                client->sendMessage(nlohmann::json{
+                                sendPayload(nlohmann::json{
                                     {"type", "callbackReply"},
                                     {"result", std::move(resultJson)},
-                                }.dump(), item.messageId);
+                                }, item.messageId);
                             }
                         });
                     }
@@ -150,14 +535,26 @@ namespace ClientAction {
         }
     }
 
-    void initSocket(std::string &address, int port) {
+    void initSocket(std::string &address, int port, const SkylineClient::Options &options) {
         if (client && client->IsConnected()) {
             logger->info("Already connected to server.");
             return;
         }
-        client = std::make_shared<SkylineClient::ClientSocket>();
-        logger->info("Connecting to server...");
-        client->Init(address, port);
+        // "unix:/path/to/skyline.sock" 使用Unix domain socket，其余按TCP地址处理
+        static const std::string unixPrefix = "unix:";
+        std::string target = address;
+        if (address.compare(0, unixPrefix.size(), unixPrefix) == 0) {
+            target = address.substr(unixPrefix.size());
+            client = std::make_shared<SkylineClient::ClientUnixSocket>(options);
+        } else {
+            client = std::make_shared<SkylineClient::ClientSocket>(options);
+        }
+        ResultMemo::clear();
+        MethodTable::clear();
+        Convert::clearCallbacks();
+        InstanceLease::clear();
+        logger->info("Connecting to server {}...", address);
+        client->Init(target, port);
         logger->info("Connected to server, starting handshake...");
 
         // Copy the shared_ptr into a local variable so the thread lambda
@@ -170,30 +567,103 @@ namespace ClientAction {
             try {
                 while (true) {
                     int64_t messageId = 0;
-                    std::string message = clientLocal->receiveMessage(&messageId);
-                    processMessage(message, messageId);
+                    uint8_t flags = 0;
+                    auto message = clientLocal->receiveMessage(&messageId, &flags);
+                    processMessage(std::move(message), messageId, flags);
                 }
             } catch (std::exception& e) {
                 logger->error("Read message error: {}", e.what());
             } catch (...) {
                 logger->error("Unknown error occurred in message reading thread.");
             }
+            {
+                // 断开期间收不到invalidate，缓存不再可信
+                std::lock_guard<std::mutex> lock(propertyCacheMutex);
+                propertyCache.clear();
+                propertyCacheEpoch++;
+            }
+            if (promiseTsfnReady.load()) {
+                {
+                    std::lock_guard<std::mutex> lock(socketRequestMutex);
+                    promiseRequests.clear();
+                }
+                promiseTsfn.NonBlockingCall(new PromiseResult{0, Frame::Message(), true}, settlePromise);
+            }
         }).detach();
     }
 
-    nlohmann::json sendMessageSync(nlohmann::json& data) {
-        if (!client || !client->IsConnected()) {
+    nlohmann::json transportStats() {
+        if (!client) {
             throw std::runtime_error("Not connected to server. Call connect() first.");
         }
-        if (requestId >= INT64_MAX - 1) {
-            requestId = 1;
+        auto stats = client->stats();
+        stats["roundTrip"] = laneStats.toJson();
+        stats["bufferPool"] = Frame::BufferPool::shared().stats();
+        stats["memo"] = ResultMemo::stats();
+        stats["methodTable"] = MethodTable::stats();
+        stats["callbacks"] = Convert::callbackStats();
+        stats["instances"] = InstanceLease::stats();
+        stats["inputEvents"] = nlohmann::json{
+            {"queued", inputEventsQueued},
+            {"coalesced", inputEventsCoalesced},
+        };
+        {
+            std::lock_guard<std::mutex> lock(propertyCacheMutex);
+            stats["propertyCache"] = nlohmann::json{
+                {"hits", propertyCacheHits.load(std::memory_order_relaxed)},
+                {"misses", propertyCacheMisses.load(std::memory_order_relaxed)},
+                {"invalidations", propertyCacheInvalidations.load(std::memory_order_relaxed)},
+                {"instances", propertyCache.size()},
+            };
         }
-        auto id = requestId;
-        requestId += 2;
+        return stats;
+    }
+
+    nlohmann::json checkEncoding(Napi::Env env, const Napi::Value &value, Frame::Codec codec) {
+        auto encodeDirect = [&](auto &encoder, uint8_t &flags) {
+            encoder.beginArray();
+            Convert::encodeValue(env, value, encoder);
+            encoder.endArray();
+            return encoder.finish(flags);
+        };
+        uint8_t directFlags = 0;
+        std::string direct;
+        if (codec == Frame::Codec::Json) {
+            Frame::JsonEncoder encoder;
+            direct = encodeDirect(encoder, directFlags);
+        } else if (codec == Frame::Codec::MsgPack) {
+            Frame::MsgPackEncoder encoder;
+            direct = encodeDirect(encoder, directFlags);
+        } else {
+            throw std::runtime_error(std::string("No direct encoder for ") + Frame::codecName(codec));
+        }
+        uint8_t referenceFlags = 0;
+        auto reference = Frame::encode(nlohmann::json::array({Convert::convertValue2Json(env, value)}), codec, referenceFlags);
+        auto directValue = Frame::decode(direct, codec, directFlags);
+        auto referenceValue = Frame::decode(reference, codec, referenceFlags);
+        return nlohmann::json{
+            {"equal", directValue == referenceValue},
+            {"direct", std::move(directValue[0])},
+            {"reference", std::move(referenceValue[0])},
+        };
+    }
+
+    /**
+     * 发送同步请求并等待响应，返回未物化的响应消息
+     *
+     * encode写出请求报文并给出flags，describe只在超时时用于日志
+     */
+    static Frame::Message request(const std::function<std::string(uint8_t &)> &encode, const std::function<std::string()> &describe) {
+        if (!client || !client->IsConnected()) {
+            throw std::runtime_error("Not connected to server. Call connect() first.");
+        }
+        uint8_t flags = 0;
+        auto payload = encode(flags);
+        auto id = nextRequestId();
         logger->info("Send to server {}", id);
 
-        auto promiseObj = std::make_shared<std::promise<std::string>>();
-        std::future<std::string> futureObj = promiseObj->get_future();
+        auto promiseObj = std::make_shared<std::promise<Frame::Message>>();
+        std::future<Frame::Message> futureObj = promiseObj->get_future();
         
         // Lock the mutex while manipulating the map
         {
@@ -206,7 +676,8 @@ namespace ClientAction {
         }
 
         logger->info("Sending message to server: {}", id);
-        client->sendMessage(std::move(data.dump()), id);
+        Frame::LaneStats::Tracker tracker(laneStats, Frame::laneOf(payload.size()));
+        sendPayload(std::move(payload), id, flags);
         logger->debug("Message sent, waiting for response: {}", id);
 
         auto start = std::chrono::steady_clock::now();
@@ -221,31 +692,24 @@ namespace ClientAction {
                 callbackQueue.pop();
             }
 
-            auto &json = item.payload;
             logger->debug("Pop msg from queue, start to handle callback.");
-            auto callbackId = json["callbackId"].get<int64_t>();
+            auto callbackId = item.message.route().callbackId;
             auto ptr = Convert::find_callback(callbackId);
             if (ptr != nullptr) {
                 logger->info("callbackId found: {}", callbackId);
                 auto env = ptr->funcRef->Env();
-                auto args = json["data"]["args"];
                 Napi::HandleScope scope(env);
-                std::vector<Napi::Value> argsVec;
-                argsVec.reserve(args.size());
-
-                for (auto &arg : args) {
-                    argsVec.push_back(Convert::convertJson2Value(env, arg));
-                }
+                auto argsVec = callbackArgs(env, item.message);
                 std::shared_ptr<Napi::FunctionReference> funcRef = ptr->funcRef;
                 auto resultValue = funcRef->Value().Call(argsVec);
 
                 auto resultJson = Convert::convertValue2Json(env, resultValue);
                 if (item.messageId > 0) {
                     logger->info("reply callback...");
-                    client->sendMessage(nlohmann::json{
+                    sendPayload(nlohmann::json{
                         {"type", "callbackReply"},
                         {"result", std::move(resultJson)},
-                    }.dump(), item.messageId);
+                    }, item.messageId);
                 }
             } else {
                 logger->error("CallbackId not found: {}", callbackId);
@@ -264,8 +728,9 @@ namespace ClientAction {
             auto delta_ms = std::chrono::duration_cast<std::chrono::milliseconds>
                 (std::chrono::steady_clock::now() - start).count();
             if (delta_ms > 5000) {
-                logger->error("Operation timed out after 5 seconds, request data:\n{}", data.dump());
-                throw std::runtime_error("Operation timed out after 5 seconds, request data:\n" + data.dump());
+                auto description = describe();
+                logger->error("Operation timed out after 5 seconds, request data:\n{}", description);
+                throw std::runtime_error("Operation timed out after 5 seconds, request data:\n" + description);
             }
 
             auto remain_ms = 5000 - delta_ms;
@@ -283,30 +748,114 @@ namespace ClientAction {
             }
         }
 
-        std::string result = futureObj.get();
-        logger->debug("Received response payload length: {}", result.size());
-
-        if (result.empty()) {
+        auto resp = futureObj.get();
+        const auto &route = resp.route();
+        if (!route.isObject) {
             throw std::runtime_error("Server response is empty");
         }
 
-        auto resp = nlohmann::json::parse(result);
-        if (resp.contains("error")) {
-            throw std::runtime_error("Server response error: " + resp["error"].get<std::string>());
+        if (route.hasError) {
+            throw std::runtime_error("Server response error: " + route.error);
         }
 
-        return resp["result"];
+        return resp;
+    }
+    static Frame::Message request(nlohmann::json& data) {
+        return request([&data](uint8_t &flags) { return encodeRequest(data, flags); },
+                       [&data]() { return data.dump(); });
     }
 
-    void sendMessageAsync(nlohmann::json& data) {
+    /**
+     * 发送请求后立即返回，响应到达后在JS主线程以pointer指向的部分调用pending.resolve
+     *
+     * 只能在JS主线程调用
+     */
+    static void requestAsync(Napi::Env env, nlohmann::json& data, PendingPromise &&pending) {
         if (!client || !client->IsConnected()) {
             throw std::runtime_error("Not connected to server. Call connect() first.");
         }
-        logger->info("send to server async");
-        client->sendMessage(data.dump(), 0);
+        if (!promiseTsfnReady.load()) {
+            promiseTsfn = Napi::ThreadSafeFunction::New(
+                env, Napi::Function::New(env, [](const Napi::CallbackInfo &info) {}), "settlePromise", 0, 1);
+            // 没有等待中的Promise时不阻止进程退出
+            promiseTsfn.Unref(env);
+            promiseTsfnReady.store(true);
+        }
+        // 先编码，编码抛出时还没有登记任何状态
+        uint8_t flags = 0;
+        auto payload = encodeRequest(data, flags);
+        auto id = nextRequestId();
+        {
+            std::lock_guard<std::mutex> lock(socketRequestMutex);
+            promiseRequests.insert(id);
+        }
+        auto lane = Frame::laneOf(payload.size());
+        pending.lane = lane;
+        pending.start = std::chrono::steady_clock::now();
+        if (pendingPromises.empty()) {
+            promiseTsfn.Ref(env);
+        }
+        pendingPromises.emplace(id, std::move(pending));
+        laneStats.begin(lane);
+        logger->debug("Send promise request to server: {}", id);
+        try {
+            sendPayload(std::move(payload), id, flags);
+        } catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(socketRequestMutex);
+                promiseRequests.erase(id);
+            }
+            pendingPromises.erase(id);
+            if (pendingPromises.empty()) {
+                promiseTsfn.Unref(env);
+            }
+            laneStats.end(lane, std::chrono::steady_clock::duration::zero());
+            throw;
+        }
+    }
+
+    static Napi::Value requestPromise(Napi::Env env, nlohmann::json& data, const std::string &pointer) {
+        auto deferred = Napi::Promise::Deferred::New(env);
+        PendingPromise pending;
+        pending.pointer = pointer;
+        pending.resolve = [deferred](Napi::Env, Napi::Value value) {
+            deferred.Resolve(value);
+        };
+        pending.reject = [deferred](Napi::Env, Napi::Value error) {
+            deferred.Reject(error);
+        };
+        requestAsync(env, data, std::move(pending));
+        return deferred.Promise();
     }
 
-    void callDynamicAsync(int64_t instanceId, const std::string& action, nlohmann::json& args) {
+    nlohmann::json sendMessageSync(nlohmann::json& data) {
+        return request(data).json("/result");
+    }
+
+    void sendMessageAsync(Napi::Env env, nlohmann::json& data) {
+        if (!client || !client->IsConnected()) {
+            throw std::runtime_error("Not connected to server. Call connect() first.");
+        }
+        logger->debug("queue async call to server");
+        queueCoalesced();
+        pendingAsync.push_back(std::move(data));
+        scheduleFlush(env);
+    }
+
+    /**
+     * 实例上的调用可能改变已记录的不变结果（如release）和缓存的属性（如setText改变display）
+     *
+     * 单向调用没有回复可以携带服务端的invalidate，先于之后的读取丢弃该实例的属性缓存
+     */
+    static void invalidateMemo(int64_t instanceId, const std::string& action) {
+        ResultMemo::invalidateAfter(ResultMemo::instanceTarget(instanceId), action);
+        std::lock_guard<std::mutex> lock(propertyCacheMutex);
+        propertyCacheEpoch++;
+        propertyCache.erase(instanceId);
+    }
+
+    void callDynamicAsync(Napi::Env env, int64_t instanceId, const std::string& action, nlohmann::json& args) {
+        invalidateMemo(instanceId, action);
         nlohmann::json json {
             {"type", "dynamic"},
             {"action", action},
@@ -316,7 +865,7 @@ namespace ClientAction {
             }}
         };
         
-        sendMessageAsync(json);
+        sendMessageAsync(env, json);
     }
 
     nlohmann::json callConstructorSync(const std::string& clazz, nlohmann::json& args) {
@@ -331,8 +880,8 @@ namespace ClientAction {
         return sendMessageSync(json);
     }
 
-    nlohmann::json callDynamicSync(int64_t instanceId, const std::string& action, nlohmann::json& args) {
-        nlohmann::json json {
+    static nlohmann::json makeDynamicCall(int64_t instanceId, const std::string& action, nlohmann::json& args) {
+        return nlohmann::json {
             {"type", "dynamic"},
             {"action", action},
             {"data", {
@@ -340,12 +889,115 @@ namespace ClientAction {
                 {"params", args}
             }}
         };
-        
-        return sendMessageSync(json);
     }
 
-    nlohmann::json callDynamicPropertySetSync(int64_t instanceId, const std::string& action, nlohmann::json& args) {
+    int64_t allocateInstanceId() {
+        return clientInstanceId++;
+    }
+
+    void callConstructorBindAsync(Napi::Env env, const std::string& clazz, int64_t bindId, nlohmann::json& args) {
         nlohmann::json json {
+            {"type", "constructor"},
+            {"clazz", clazz},
+            {"data", {
+                {"params", args},
+                {"bindId", bindId}
+            }}
+        };
+
+        sendMessageAsync(env, json);
+    }
+
+    nlohmann::json callDynamicSync(int64_t instanceId, const std::string& action, nlohmann::json& args) {
+        invalidateMemo(instanceId, action);
+        auto json = makeDynamicCall(instanceId, action, args);
+        return sendMessageSync(json);
+    }
+
+    Napi::Value callDynamicSync(Napi::Env env, int64_t instanceId, const std::string& action, nlohmann::json& args) {
+        auto target = ResultMemo::instanceTarget(instanceId);
+        // 临时代理的id在解析后会变，不记录
+        if (instanceId > 0 && ResultMemo::isPure(target, action)) {
+            nlohmann::json result;
+            auto replay = ResultMemo::lookup(target, action, args, result);
+            if (!replay) {
+                auto json = makeDynamicCall(instanceId, action, args);
+                result = sendMessageSync(json);
+                ResultMemo::store(target, action, args, result);
+            }
+            InstanceLease::Replay scope(replay);
+            return Convert::convertJson2Value(env, result["returnValue"]);
+        }
+        invalidateMemo(instanceId, action);
+        auto json = makeDynamicCall(instanceId, action, args);
+        auto resp = request(json);
+        return Convert::convertMessage2Value(env, resp, "/result/returnValue");
+    }
+
+    Napi::Value callDynamicSync(Napi::Env env, int64_t instanceId, const std::string& action, const Napi::CallbackInfo& info) {
+        auto target = ResultMemo::instanceTarget(instanceId);
+        // 记录结果需要以参数的json为键；CBOR没有直接编码
+        if ((instanceId > 0 && ResultMemo::isPure(target, action)) || !client || client->codec() == Frame::Codec::Cbor) {
+            nlohmann::json args = nlohmann::json::array();
+            for (size_t i = 0; i < info.Length(); i++) {
+                args[i] = Convert::convertValue2Json(env, info[i]);
+            }
+            return callDynamicSync(env, instanceId, action, args);
+        }
+        invalidateMemo(instanceId, action);
+        auto write = [&](auto &shared, bool &busy, int64_t methodId, uint8_t &flags) {
+            std::decay_t<decltype(shared)> scratch;
+            auto wasBusy = busy;
+            auto &encoder = wasBusy ? scratch : shared;
+            busy = true;
+            try {
+                encoder.beginObject();
+                encoder.key("data");
+                encoder.beginObject();
+                encoder.key("instanceId");
+                encoder.integer(instanceId);
+                encoder.key("params");
+                encoder.beginArray();
+                for (size_t i = 0; i < info.Length(); i++) {
+                    Convert::encodeValue(env, info[i], encoder);
+                }
+                encoder.endArray();
+                encoder.endObject();
+                encoder.key("m");
+                encoder.integer(methodId);
+                encoder.key("t");
+                encoder.integer(MethodTable::typeId("dynamic"));
+                encoder.endObject();
+            } catch (...) {
+                encoder.reset();
+                busy = wasBusy;
+                throw;
+            }
+            busy = wasBusy;
+            return encoder.finish(flags);
+        };
+        auto encode = [&](uint8_t &flags) {
+            flushCoalesced();
+            flushAsync();
+            auto methodId = MethodTable::nameId(action);
+            sendDefinitions();
+            if (client->codec() == Frame::Codec::MsgPack) {
+                return write(msgpackRequestEncoder, msgpackRequestEncoderBusy, methodId, flags);
+            }
+            return write(requestEncoder, requestEncoderBusy, methodId, flags);
+        };
+        auto resp = request(encode, [&]() { return "dynamic " + action + " on " + std::to_string(instanceId); });
+        return Convert::convertMessage2Value(env, resp, "/result/returnValue");
+    }
+
+    Napi::Value callDynamicPromise(Napi::Env env, int64_t instanceId, const std::string& action, nlohmann::json& args) {
+        invalidateMemo(instanceId, action);
+        auto json = makeDynamicCall(instanceId, action, args);
+        return requestPromise(env, json, "/result/returnValue");
+    }
+
+    static nlohmann::json makeDynamicPropertySet(int64_t instanceId, const std::string& action, nlohmann::json& args) {
+        return nlohmann::json {
             {"type", "dynamicProperty"},
             {"action", action},
             {"data", {
@@ -354,12 +1006,147 @@ namespace ClientAction {
                 {"propertyAction", "set"},
             }}
         };
-        
+    }
+
+    /**
+     * 合并后的写入移入异步调用队列；之后排队的调用必须排在这些写入之后
+     */
+    static void queueCoalesced() {
+        if (dirtyOrder.empty()) {
+            return;
+        }
+        logger->debug("Queue {} coalesced property writes", dirtyOrder.size());
+        for (const auto &key : dirtyOrder) {
+            auto &value = dirtyProperties[key];
+            nlohmann::json args = nlohmann::json::array({std::move(value)});
+            pendingAsync.push_back(makeDynamicPropertySet(key.first, key.second, args));
+        }
+        dirtyOrder.clear();
+        dirtyProperties.clear();
+    }
+
+    /**
+     * 合并后的写入加入异步调用队列，作为一个batch帧发送
+     */
+    static void flushCoalesced() {
+        frameFlushScheduled = false;
+        if (dirtyOrder.empty()) {
+            return;
+        }
+        queueCoalesced();
+        flushAsync();
+    }
+
+    /**
+     * 丢弃某个实例尚未发出的合并写入（流水线读取失败的临时代理）
+     */
+    static void discardCoalesced(int64_t instanceId) {
+        auto removed = std::remove_if(dirtyOrder.begin(), dirtyOrder.end(), [instanceId](const auto &key) {
+            return key.first == instanceId;
+        });
+        for (auto it = removed; it != dirtyOrder.end(); ++it) {
+            dirtyProperties.erase(*it);
+        }
+        dirtyOrder.erase(removed, dirtyOrder.end());
+    }
+
+    /**
+     * 帧定时器到期：发出合并后的写入，以及按帧节流、只排入队列的输入事件
+     */
+    static void flushFrame() {
+        flushCoalesced();
+        flushAsync();
+    }
+
+    /**
+     * 每帧发送一次合并后的写入和节流的事件
+     */
+    static void scheduleFrameFlush(Napi::Env env) {
+        if (frameFlushScheduled) {
+            return;
+        }
+        if (!flushFrameRef) {
+            flushFrameRef = std::make_shared<Napi::FunctionReference>(Napi::Persistent(
+                Napi::Function::New(env, [](const Napi::CallbackInfo &info) {
+                    try {
+                        flushFrame();
+                    } catch (const std::exception &e) {
+                        logger->error("Flush coalesced property writes error: {}", e.what());
+                    }
+                }, "flushFrame")));
+        }
+        auto setTimeout = env.Global().Get("setTimeout");
+        if (!setTimeout.IsFunction()) {
+            flushFrame();
+            return;
+        }
+        setTimeout.As<Napi::Function>().Call({flushFrameRef->Value(), Napi::Number::New(env, kFrameIntervalMs)});
+        frameFlushScheduled = true;
+    }
+
+    void callDynamicPropertySetCoalesced(Napi::Env env, int64_t instanceId, const std::string& action, const nlohmann::json& value) {
+        if (!client || !client->IsConnected()) {
+            throw std::runtime_error("Not connected to server. Call connect() first.");
+        }
+        auto key = std::make_pair(instanceId, action);
+        auto target = dirtyProperties.find(key);
+        if (target == dirtyProperties.end()) {
+            dirtyProperties.emplace(key, value);
+            dirtyOrder.push_back(std::move(key));
+        } else {
+            target->second = value;
+        }
+        scheduleFrameFlush(env);
+    }
+
+    void callDynamicEventAsync(Napi::Env env, int64_t instanceId, const std::string& action, nlohmann::json& args, bool coalesce) {
+        if (!client || !client->IsConnected()) {
+            throw std::runtime_error("Not connected to server. Call connect() first.");
+        }
+        inputEventsQueued++;
+        queueCoalesced();
+        if (coalesce && mergeableEvent + 1 == pendingAsync.size()) {
+            auto &last = pendingAsync.back();
+            if (last["action"] == action && last["data"]["instanceId"] == instanceId) {
+                last["data"]["params"] = args;
+                inputEventsCoalesced++;
+                scheduleFrameFlush(env);
+                return;
+            }
+        }
+        pendingAsync.push_back(makeDynamicCall(instanceId, action, args));
+        if (coalesce) {
+            mergeableEvent = pendingAsync.size() - 1;
+            scheduleFrameFlush(env);
+            return;
+        }
+        // start/end/cancel不能合并，不等帧定时器，当前任务结束时连同之前排队的事件一起发出
+        mergeableEvent = SIZE_MAX;
+        scheduleFlush(env);
+    }
+
+    void onAsyncError(Napi::Env env, std::function<void(Napi::Env, const std::string &)> handler) {
+        asyncErrorHandler = std::move(handler);
+        if (!asyncErrorTsfnReady.load()) {
+            asyncErrorTsfn = Napi::ThreadSafeFunction::New(
+                env, Napi::Function::New(env, [](const Napi::CallbackInfo &info) {}), "asyncError", 0, 1);
+            asyncErrorTsfn.Unref(env);
+            asyncErrorTsfnReady.store(true);
+        }
+    }
+
+    void callDynamicPropertySetAsync(Napi::Env env, int64_t instanceId, const std::string& action, nlohmann::json& args) {
+        auto json = makeDynamicPropertySet(instanceId, action, args);
+        sendMessageAsync(env, json);
+    }
+
+    nlohmann::json callDynamicPropertySetSync(int64_t instanceId, const std::string& action, nlohmann::json& args) {
+        auto json = makeDynamicPropertySet(instanceId, action, args);
         return sendMessageSync(json);
     }
 
-    nlohmann::json callDynamicPropertyGetSync(int64_t instanceId, const std::string& action) {
-        nlohmann::json json {
+    static nlohmann::json makeDynamicPropertyGet(int64_t instanceId, const std::string& action) {
+        return nlohmann::json {
             {"type", "dynamicProperty"},
             {"action", action},
             {"data", {
@@ -367,10 +1154,172 @@ namespace ClientAction {
                 {"propertyAction", "get"},
             }}
         };
-        
+    }
+
+    nlohmann::json callDynamicPropertyGetSync(int64_t instanceId, const std::string& action) {
+        auto json = makeDynamicPropertyGet(instanceId, action);
         return sendMessageSync(json);
     }
 
+    Napi::Value callDynamicPropertyGetSync(Napi::Env env, int64_t instanceId, const std::string& action) {
+        auto json = makeDynamicPropertyGet(instanceId, action);
+        auto resp = request(json);
+        return Convert::convertMessage2Value(env, resp, "/result/returnValue");
+    }
+
+    Napi::Value callDynamicPropertyGetCached(Napi::Env env, int64_t instanceId, const std::string& action) {
+        // 流水线代理的id是临时的，不缓存
+        if (instanceId <= 0) {
+            return callDynamicPropertyGetSync(env, instanceId, action);
+        }
+        uint64_t epoch = 0;
+        bool hit = false;
+        nlohmann::json cached;
+        {
+            std::lock_guard<std::mutex> lock(propertyCacheMutex);
+            if (auto target = propertyCache.find(instanceId); target != propertyCache.end()) {
+                if (auto value = target->second.find(action); value != target->second.end()) {
+                    cached = value->second;
+                    hit = true;
+                }
+            }
+            epoch = propertyCacheEpoch;
+        }
+        if (hit) {
+            propertyCacheHits.fetch_add(1, std::memory_order_relaxed);
+            return Convert::convertJson2Value(env, cached);
+        }
+        propertyCacheMisses.fetch_add(1, std::memory_order_relaxed);
+        auto json = makeDynamicPropertyGet(instanceId, action);
+        auto resp = request(json);
+        if (resp.json("/result/cacheable") != true) {
+            return Convert::convertMessage2Value(env, resp, "/result/returnValue");
+        }
+        auto value = resp.json("/result/returnValue");
+        {
+            std::lock_guard<std::mutex> lock(propertyCacheMutex);
+            if (epoch == propertyCacheEpoch) {
+                propertyCache[instanceId][action] = value;
+            }
+        }
+        return Convert::convertJson2Value(env, value);
+    }
+
+    nlohmann::json callDynamicPropertiesGetSync(int64_t instanceId, const std::vector<std::string>& properties) {
+        nlohmann::json values = nlohmann::json::object();
+        std::vector<std::string> missing;
+        uint64_t epoch = 0;
+        {
+            std::lock_guard<std::mutex> lock(propertyCacheMutex);
+            auto target = instanceId > 0 ? propertyCache.find(instanceId) : propertyCache.end();
+            for (const auto &name : properties) {
+                if (target != propertyCache.end()) {
+                    if (auto value = target->second.find(name); value != target->second.end()) {
+                        values[name] = value->second;
+                        propertyCacheHits.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+                }
+                missing.push_back(name);
+            }
+            epoch = propertyCacheEpoch;
+        }
+        if (missing.empty()) {
+            return values;
+        }
+        propertyCacheMisses.fetch_add(missing.size(), std::memory_order_relaxed);
+        nlohmann::json json {
+            {"type", "dynamicProperties"},
+            {"data", {
+                {"instanceId", instanceId},
+                {"properties", missing},
+            }}
+        };
+        auto result = sendMessageSync(json);
+        auto &fetched = result["returnValue"];
+        if (!fetched.is_object()) {
+            return values;
+        }
+        if (instanceId > 0 && result["cacheable"].is_array()) {
+            std::lock_guard<std::mutex> lock(propertyCacheMutex);
+            if (epoch == propertyCacheEpoch) {
+                for (const auto &name : result["cacheable"]) {
+                    if (name.is_string() && fetched.contains(name.get<std::string>())) {
+                        propertyCache[instanceId][name.get<std::string>()] = fetched[name.get<std::string>()];
+                    }
+                }
+            }
+        }
+        for (auto item = fetched.begin(); item != fetched.end(); ++item) {
+            values[item.key()] = std::move(item.value());
+        }
+        return values;
+    }
+
+    void evictCachedProperty(int64_t instanceId, const std::string& action) {
+        std::lock_guard<std::mutex> lock(propertyCacheMutex);
+        propertyCacheEpoch++;
+        auto target = propertyCache.find(instanceId);
+        if (target == propertyCache.end()) {
+            return;
+        }
+        target->second.erase(action);
+    }
+
+    Napi::Value callDynamicPropertyGetPromise(Napi::Env env, int64_t instanceId, const std::string& action) {
+        auto json = makeDynamicPropertyGet(instanceId, action);
+        return requestPromise(env, json, "/result/returnValue");
+    }
+
+    int64_t callDynamicPropertyGetPipelined(Napi::Env env, int64_t instanceId, const std::string& action,
+                                            std::function<void(Napi::Env, int64_t, int64_t)> resolved,
+                                            std::function<void(Napi::Env, int64_t, const std::string &)> rejected) {
+        if (pipelineAnswerId >= Frame::kMaxMessageId) {
+            pipelineAnswerId = 1;
+        }
+        auto answerId = pipelineAnswerId++;
+        auto json = makeDynamicPropertyGet(instanceId, action);
+        json["data"]["answerId"] = answerId;
+
+        // 代理换成真实id后，后续请求不再引用该结果，通知服务端释放；随异步调用一起发送
+        auto release = [answerId](Napi::Env env) {
+            nlohmann::json json {
+                {"type", "releaseAnswer"},
+                {"data", {
+                    {"answerId", answerId},
+                }}
+            };
+            try {
+                sendMessageAsync(env, json);
+            } catch (const std::exception &e) {
+                logger->warn("Release pipeline answer {} failed: {}", answerId, e.what());
+            }
+        };
+        PendingPromise pending;
+        pending.pointer = "/result/returnValue/instanceId";
+        pending.resolve = [answerId, resolved, rejected, release](Napi::Env env, Napi::Value value) {
+            if (value.IsNumber()) {
+                resolved(env, answerId, value.As<Napi::Number>().Int64Value());
+                // 以临时id合并的写入要在释放之前发出，释放后服务端不再认识该id
+                flushCoalesced();
+            } else {
+                logger->error("Pipelined result {} is not an instance", answerId);
+                discardCoalesced(-answerId);
+                rejected(env, answerId, "Pipelined property is not an instance");
+            }
+            release(env);
+        };
+        pending.reject = [answerId, rejected, release](Napi::Env env, Napi::Value error) {
+            auto message = error.As<Napi::Object>().Get("message").ToString().Utf8Value();
+            logger->error("Pipelined request {} failed: {}", answerId, message);
+            discardCoalesced(-answerId);
+            rejected(env, answerId, message);
+            release(env);
+        };
+        requestAsync(env, json, std::move(pending));
+        return answerId;
+    }
+
     nlohmann::json callStaticSync(const std::string& clazz, const std::string& action, nlohmann::json& args) {
         nlohmann::json json {
             {"type", "static"},
@@ -381,7 +1330,16 @@ namespace ClientAction {
             }}
         };
         
-        return sendMessageSync(json);
+        auto target = ResultMemo::staticTarget(clazz);
+        if (!ResultMemo::isPure(target, action)) {
+            return sendMessageSync(json);
+        }
+        nlohmann::json result;
+        if (!ResultMemo::lookup(target, action, args, result)) {
+            result = sendMessageSync(json);
+            ResultMemo::store(target, action, args, result);
+        }
+        return result;
     }
 
     nlohmann::json callCustomHandleSync(const std::string& action, nlohmann::json& args) {
@@ -1,20 +1,133 @@
 #ifndef __SOCKET_CLIENT_HH__
 #define __SOCKET_CLIENT_HH__
+#include <functional>
 #include <string>
+#include <vector>
 #include <nlohmann/json.hpp>
 #include <napi.h>
+#include "../common/frame.hh"
+#include "client.hh"
 
 namespace ClientAction {
     /**
      * 初始化Socket，并连接到服务器
      */
-    void initSocket(std::string &address, int port);
+    void initSocket(std::string &address, int port, const SkylineClient::Options &options = SkylineClient::Options());
+    /**
+     * 当前连接的传输统计
+     */
+    nlohmann::json transportStats();
+    /**
+     * 调试用：value分别经encodeValue直接编码和经convertValue2Json构建后编码，
+     * 解码后比较两者。用于确认两条编码路径等价，不需要连接
+     */
+    nlohmann::json checkEncoding(Napi::Env env, const Napi::Value &value, Frame::Codec codec);
     nlohmann::json callConstructorSync(const std::string& clazz, nlohmann::json& data);
     nlohmann::json callStaticSync(const std::string& clazz, const std::string& action, nlohmann::json& data);
     nlohmann::json callDynamicSync(int64_t instanceId, const std::string& action, nlohmann::json& data);
     nlohmann::json callDynamicPropertySetSync(int64_t instanceId, const std::string& action, nlohmann::json& data);
+    /**
+     * 属性设置作为单向请求与异步调用按顺序合并发送，不等待服务端
+     *
+     * 下一次同步调用前一定已发出，服务端按顺序处理，之后的读取能看到写入的值；
+     * 服务端设置失败时通过onAsyncError登记的回调报告
+     */
+    void callDynamicPropertySetAsync(Napi::Env env, int64_t instanceId, const std::string& action, nlohmann::json& data);
+    /**
+     * 按帧合并的属性写入，用于动画中每帧多次写入的值
+     *
+     * 每个(实例, 属性)只保留最新的值，约每帧（16ms）合并为一个batch帧发送；
+     * 同步调用前会先发出，之后排队的异步调用和输入事件排在这些写入之后。
+     * 读取该属性时先发出写入，以服务端的值为准
+     */
+    void callDynamicPropertySetCoalesced(Napi::Env env, int64_t instanceId, const std::string& action, const nlohmann::json& value);
+    /**
+     * 输入事件单向发送
+     *
+     * coalesce为true的事件（move/wheel/over）随按帧合并的写入一起发出，紧邻的上一个事件
+     * 是同一实例的同名事件则只保留新的参数；其他事件在当前任务结束时（微任务）发出。
+     * 中间插入了其他调用（如touchStart/touchEnd）时不合并，保证相对顺序
+     */
+    void callDynamicEventAsync(Napi::Env env, int64_t instanceId, const std::string& action, nlohmann::json& args, bool coalesce);
+    /**
+     * 登记单向请求在服务端失败时的回调，在JS主线程调用
+     */
+    void onAsyncError(Napi::Env env, std::function<void(Napi::Env, const std::string &)> handler);
     nlohmann::json callDynamicPropertyGetSync(int64_t instanceId, const std::string& action);
-    void callDynamicAsync(int64_t instanceId, const std::string& action, nlohmann::json& data);
+    /**
+     * 直接返回result.returnValue对应的JS值，JSON编码时跳过中间的nlohmann::json
+     */
+    Napi::Value callDynamicSync(Napi::Env env, int64_t instanceId, const std::string& action, nlohmann::json& data);
+    /**
+     * 参数直接从JS值编码到报文，不经过nlohmann::json；JSON编码以外退回上面的版本
+     */
+    Napi::Value callDynamicSync(Napi::Env env, int64_t instanceId, const std::string& action, const Napi::CallbackInfo& info);
+    Napi::Value callDynamicPropertyGetSync(Napi::Env env, int64_t instanceId, const std::string& action);
+    /**
+     * 读取property，服务端标记为cacheable的值保存在本地，直到服务端发送invalidate
+     */
+    Napi::Value callDynamicPropertyGetCached(Napi::Env env, int64_t instanceId, const std::string& action);
+    /**
+     * 一次往返读取同一实例的多个属性，返回属性名 -> 值
+     *
+     * 已缓存或尚未发出的合并写入直接取本地的值，只请求其余属性；服务端允许缓存的值写入缓存
+     */
+    nlohmann::json callDynamicPropertiesGetSync(int64_t instanceId, const std::vector<std::string>& properties);
+    /**
+     * 设置property后丢弃已缓存的值
+     *
+     * 写入是单向的，服务端可能拒绝或改写该值（如规范化的样式值），之后的读取以服务端为准
+     */
+    void evictCachedProperty(int64_t instanceId, const std::string& action);
+    /**
+     * 与callDynamicSync相同的请求，立即返回Promise，不阻塞JS主线程
+     *
+     * 响应由接收线程经ThreadSafeFunction交回主线程resolve，可同时有多个请求在途；
+     * 服务端返回错误时reject，连接断开时所有未完成的Promise都会reject。
+     * 只能在JS主线程调用
+     */
+    Napi::Value callDynamicPromise(Napi::Env env, int64_t instanceId, const std::string& action, nlohmann::json& data);
+    Napi::Value callDynamicPropertyGetPromise(Napi::Env env, int64_t instanceId, const std::string& action);
+    /**
+     * 流水线读取实例类型的属性，不等待响应，返回结果编号answerId
+     *
+     * 服务端把读取结果暂存在answerId下，实例id传-answerId即可在结果到达前对其发起调用，
+     * 服务端按收到的顺序解析，整条调用链只需一次往返。
+     * 响应到达后在JS主线程调用resolved(env, answerId, 真实实例id)，随后通知服务端释放暂存的结果；
+     * 读取失败时调用rejected(env, answerId, 错误信息)，以临时id合并的写入随之丢弃。
+     * 只能在JS主线程调用
+     */
+    int64_t callDynamicPropertyGetPipelined(Napi::Env env, int64_t instanceId, const std::string& action,
+                                            std::function<void(Napi::Env, int64_t, int64_t)> resolved,
+                                            std::function<void(Napi::Env, int64_t, const std::string &)> rejected);
+    /**
+     * 异步调用先缓存在本地，当前JS任务结束时或下一次同步调用前合并为一个batch帧发送
+     *
+     * 只能在JS主线程调用
+     */
+    void callDynamicAsync(Napi::Env env, int64_t instanceId, const std::string& action, nlohmann::json& data);
+    /**
+     * 客户端分配的实例id从此开始，服务端自增的id不会到达这一范围
+     */
+    constexpr int64_t kClientInstanceIdBase = int64_t(1) << 40;
+    /**
+     * 分配一个客户端实例id，只能在JS主线程调用
+     */
+    int64_t allocateInstanceId();
+    /**
+     * 与异步调用一起合并发送，服务端把构造出的对象登记在bindId下，不回复
+     *
+     * 调用方无需等待即可用bindId引用结果，下一次同步调用前这些请求已经发出，服务端按顺序处理
+     */
+    void callConstructorBindAsync(Napi::Env env, const std::string& clazz, int64_t bindId, nlohmann::json& data);
+    /**
+     * 立即发送缓存的异步调用
+     */
+    void flushAsync();
+    /**
+     * 启动定时器，定时发出排队的实例释放；只需调用一次
+     */
+    void startReleaseTimer(Napi::Env env);
     nlohmann::json callCustomHandleSync(const std::string& action, nlohmann::json& data);
 }
 
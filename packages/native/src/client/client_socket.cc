@@ -12,33 +12,90 @@ using boost::asio::ip::tcp;
 using Logger::logger;
 
 namespace SkylineClient {
-namespace {
-uint64_t hostToNetwork64(uint64_t value) {
-  static const uint16_t one = 1;
-  if (*reinterpret_cast<const uint8_t *>(&one) == 0) {
-    return value;
-  }
-  const uint32_t high = htonl(static_cast<uint32_t>(value >> 32));
-  const uint32_t low = htonl(static_cast<uint32_t>(value & 0xFFFFFFFFULL));
-  return (static_cast<uint64_t>(low) << 32) | high;
+
+ClientSocket::ClientSocket(const Options &options)
+    : options(options), compressor(options.compressThreshold) {}
+
+void ClientSocket::handshake() {
+    uint32_t handshake_value;
+    boost::asio::read(*socket, boost::asio::buffer(&handshake_value, sizeof(handshake_value)));
+    handshake_value = ntohl(handshake_value);
+    if (handshake_value != Frame::kHandshakeMagic) {
+        throw std::runtime_error("Invalid handshake from server: " + std::to_string(handshake_value));
+    }
+    uint32_t capabilities;
+    boost::asio::read(*socket, boost::asio::buffer(&capabilities, sizeof(capabilities)));
+    capabilities = ntohl(capabilities);
+
+    negotiated_codec = Frame::negotiateCodec(capabilities, options.codec);
+    uint32_t features = 0;
+    compressor.setEnabled(options.compressThreshold > 0 && Frame::hasCompression(capabilities));
+    if (compressor.enabled()) {
+        features |= Frame::kCompressionBit;
+    }
+    chunking = Frame::hasChunking(capabilities);
+    if (chunking) {
+        features |= Frame::kChunkingBit;
+    }
+    channel.reset();
+    std::string channelName;
+    if (options.sharedMemory && Frame::hasSharedMemory(capabilities)) {
+        try {
+            channelName = Shm::Channel::uniqueName();
+            channel = Shm::Channel::create(channelName, *socket);
+        } catch (const std::exception &e) {
+            logger->warn("Shared memory unavailable, falling back to socket: {}", e.what());
+        }
+    }
+    if (channel) {
+        features |= Frame::kSharedMemoryBit;
+    }
+    uint32_t selection = htonl(Frame::encodeSelection(negotiated_codec, features));
+    boost::asio::write(*socket, boost::asio::buffer(&selection, sizeof(selection)));
+    logger->info("Negotiated wire codec: {}", Frame::codecName(negotiated_codec));
+    if (channel && !upgradeToSharedMemory(channelName)) {
+        channel.reset();
+    }
 }
 
-uint64_t networkToHost64(uint64_t value) { return hostToNetwork64(value); }
-} // namespace
+bool ClientSocket::upgradeToSharedMemory(const std::string &name) {
+    // 共享内存名称：uint32 长度 + 内容；服务端回复 uint32 1成功 0失败
+    uint32_t length = htonl(static_cast<uint32_t>(name.size()));
+    std::array<boost::asio::const_buffer, 2> buffers = {
+        boost::asio::buffer(&length, sizeof(length)),
+        boost::asio::buffer(name)
+    };
+    boost::asio::write(*socket, buffers);
+    uint32_t ack = 0;
+    boost::asio::read(*socket, boost::asio::buffer(&ack, sizeof(ack)));
+    // 双方都已映射或服务端已放弃，名称不再需要
+    channel->unlink();
+    if (ntohl(ack) != 1) {
+        logger->warn("Server failed to open shared memory, falling back to socket");
+        return false;
+    }
+    logger->info("Upgraded transport to shared memory: {}", name);
+    return true;
+}
 
-void ClientSocket::Init(std::string &address, int port) {
-    this->server_address = address;
-    this->server_port = port;
+std::unique_ptr<ClientSocket::stream_socket> ClientSocket::connect() {
     tcp::resolver resolver(io_context);
     auto endpoints =
-        resolver.resolve(address, std::to_string(port));
+        resolver.resolve(server_address, std::to_string(server_port));
+
+    tcp::socket tcp_socket(io_context);
+    boost::asio::connect(tcp_socket, endpoints);
 
-    socket = std::make_unique<tcp::socket>(io_context);
-    boost::asio::connect(*socket, endpoints);
-    
     // Enable TCP_NODELAY to reduce latency
     boost::asio::ip::tcp::no_delay option(true);
-    socket->set_option(option);
+    tcp_socket.set_option(option);
+    return std::make_unique<stream_socket>(std::move(tcp_socket));
+}
+
+void ClientSocket::Init(std::string &address, int port) {
+    this->server_address = address;
+    this->server_port = port;
+    socket = connect();
 
     // Start a thread for the io_context
     std::thread([this]() {
@@ -50,13 +107,15 @@ void ClientSocket::Init(std::string &address, int port) {
     }).detach();
 
     // Handshake with server
-    uint32_t handshake_value;
     for (int i=0; i<5; i++) {
         try  {
-            boost::asio::read(*socket, boost::asio::buffer(&handshake_value, sizeof(handshake_value)));
-            handshake_value = ntohl(handshake_value);
-            if (handshake_value != 114514) {
-                throw std::runtime_error("Invalid handshake from server: " + std::to_string(handshake_value));
+            handshake();
+            if (!channel) {
+                writer = std::make_unique<Frame::Writer>(*socket, [this](const std::exception &e) {
+                    logger->error("Error sending message: {}", e.what());
+                    this->is_connected = false;
+                }, chunking);
+                reader = std::make_unique<Frame::Reader>(*socket, compressor);
             }
             logger->info("Successfully connected to server after handshake");
             this->is_connected = true;
@@ -66,20 +125,20 @@ void ClientSocket::Init(std::string &address, int port) {
             logger->error("Handshake error (attempt {}/5): {}", i+1, err.what());
             
             // Close and recreate socket for clean retry
+            channel.reset();
             if (socket && socket->is_open()) {
                 try {
                     socket->close();
                 } catch(...) {}
             }
-            socket = std::make_unique<tcp::socket>(io_context);
+            socket = std::make_unique<stream_socket>(io_context);
             
             // Wait a bit before retrying
             std::this_thread::sleep_for(std::chrono::seconds(1));
             
             // Try to reconnect
             try {
-                boost::asio::connect(*socket, endpoints);
-                socket->set_option(boost::asio::ip::tcp::no_delay(true));
+                socket = connect();
             } catch(const std::exception& connect_err) {
                 logger->error("Reconnect failed: {}", connect_err.what());
             }
@@ -94,51 +153,51 @@ bool ClientSocket::IsConnected() {
     return socket && socket->is_open() && this->is_connected;
 }
 
-void ClientSocket::sendMessage(std::string&& message, std::int64_t messageId) {
-    if (socket && socket->is_open() && this->is_connected) {
-        logger->debug("Sending message with length: {}", message.size());
-        std::array<uint8_t, sizeof(uint32_t) + sizeof(uint64_t)> header{};
-        const uint32_t message_length = htonl(static_cast<uint32_t>(message.size()));
-        const uint64_t message_id = hostToNetwork64(static_cast<uint64_t>(messageId));
-        std::memcpy(header.data(), &message_length, sizeof(message_length));
-        std::memcpy(header.data() + sizeof(uint32_t), &message_id, sizeof(message_id));
-        std::array<boost::asio::const_buffer, 2> buffers = {
-            boost::asio::buffer(header.data(), header.size()),
-            boost::asio::buffer(message)
-        };
+Frame::Codec ClientSocket::codec() {
+    return negotiated_codec;
+}
+
+nlohmann::json ClientSocket::stats() {
+    return nlohmann::json{
+        {"transport", channel ? "sharedMemory" : "socket"},
+        {"codec", Frame::codecName(negotiated_codec)},
+        {"compression", compressor.stats()},
+        {"sendQueue", writer ? writer->stats() : nlohmann::json()},
+    };
+}
+
+void ClientSocket::sendMessage(std::string&& message, std::int64_t messageId, std::uint8_t flags) {
+    if (channel && this->is_connected) {
+        std::lock_guard<std::mutex> lock(channel_send_mutex);
         try {
-            boost::asio::write(*socket, buffers);
+            channel->sendMessage(message, messageId, flags);
         } catch (const std::exception &e) {
             logger->error("Error sending message: {}", e.what());
             this->is_connected = false;
-            throw e;
+            throw;
         }
+    } else if (writer && this->is_connected) {
+        logger->debug("Sending message with length: {}", message.size());
+        // 共享内存不受带宽限制，只在socket上压缩
+        compressor.deflate(message, flags);
+        writer->push(std::move(message), messageId, flags);
     } else {
         logger->error("Socket is not open or not connected");
     }
 }
-std::string ClientSocket::receiveMessage(std::int64_t *messageId) {
-    if (socket && socket->is_open() && this->is_connected) {
-        std::array<uint8_t, sizeof(uint32_t) + sizeof(uint64_t)> header{};
-        boost::asio::read(*socket, boost::asio::buffer(header.data(), header.size()));
-
-        uint32_t message_length_net = 0;
-        std::memcpy(&message_length_net, header.data(), sizeof(message_length_net));
-        const uint32_t message_length = ntohl(message_length_net);
-
-        uint64_t raw_message_id = 0;
-        std::memcpy(&raw_message_id, header.data() + sizeof(uint32_t), sizeof(raw_message_id));
-        if (messageId != nullptr) {
-            *messageId = static_cast<int64_t>(networkToHost64(raw_message_id));
+Frame::Buffer ClientSocket::receiveMessage(std::int64_t *messageId, std::uint8_t *flags) {
+    if (channel && this->is_connected) {
+        try {
+            return channel->receiveMessage(messageId, flags);
+        } catch (const std::exception &) {
+            this->is_connected = false;
+            throw;
         }
-
-        // Then read the actual message
-        std::string message(message_length, '\0');
-        boost::asio::read(*socket, boost::asio::buffer(message.data(), message_length));
-        return message;
+    } else if (reader && this->is_connected) {
+        return reader->read(messageId, flags);
     } else {
         logger->error("Socket is not open or not connected");
-        return "";
+        return Frame::Buffer();
     }
 }
 
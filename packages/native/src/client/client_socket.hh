@@ -6,28 +6,62 @@
 #pragma comment(lib, "ws2_32.lib")
 #endif
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <napi.h>
 #include "client.hh"
+#include "../common/frame_reader.hh"
+#include "../common/frame_writer.hh"
+#include "../common/shm_channel.hh"
 #include <boost/asio.hpp>
 
 namespace SkylineClient {
     
 using boost::asio::ip::tcp;
+/**
+ * 基于流式socket的传输层，默认TCP
+ *
+ * 帧格式、握手与收发逻辑与具体协议无关，子类只需替换connect()
+ * options.sharedMemory为true且服务端支持时，握手后帧改走共享内存（见Shm::Channel）
+ * socket上的发送由Frame::Writer的发送线程完成，调用方只负责入队
+ */
 class ClientSocket : public Client {
     public:
+    using stream_socket = boost::asio::generic::stream_protocol::socket;
+
+    explicit ClientSocket(const Options &options = Options());
     void Init(std::string &, int);
     bool IsConnected();
-    ~ClientSocket();
-    void sendMessage(std::string&& message, std::int64_t messageId = 0);
-    std::string receiveMessage(std::int64_t *messageId = nullptr);
+    Frame::Codec codec();
+    nlohmann::json stats();
+    virtual ~ClientSocket();
+    void sendMessage(std::string&& message, std::int64_t messageId = 0, std::uint8_t flags = 0);
+    Frame::Buffer receiveMessage(std::int64_t *messageId = nullptr, std::uint8_t *flags = nullptr);
 
-    private:
+    protected:
+    // 建立到服务端的连接
+    virtual std::unique_ptr<stream_socket> connect();
     boost::asio::io_context io_context;
-    std::unique_ptr<tcp::socket> socket;
-    bool is_connected = false;
     std::string server_address;
     int server_port;
+
+    private:
+    void handshake();
+    // 握手成功后尝试升级到共享内存，失败时继续使用socket
+    bool upgradeToSharedMemory(const std::string &name);
+
+    std::unique_ptr<stream_socket> socket;
+    std::unique_ptr<Shm::Channel> channel;
+    std::mutex channel_send_mutex;
+    Options options;
+    Frame::Compressor compressor;
+    std::unique_ptr<Frame::Writer> writer;
+    std::unique_ptr<Frame::Reader> reader;
+    bool chunking = false;
+    std::atomic<bool> is_connected{false};
+    Frame::Codec negotiated_codec = Frame::Codec::Json;
 };
 }
 
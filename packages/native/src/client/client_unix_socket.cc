@@ -0,0 +1,17 @@
+#include "client_unix_socket.hh"
+#include <boost/asio.hpp>
+#include <memory>
+#include <stdexcept>
+
+namespace SkylineClient {
+
+std::unique_ptr<ClientSocket::stream_socket> ClientUnixSocket::connect() {
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+    boost::asio::local::stream_protocol::socket unix_socket(io_context);
+    unix_socket.connect(boost::asio::local::stream_protocol::endpoint(server_address));
+    return std::make_unique<stream_socket>(std::move(unix_socket));
+#else
+    throw std::runtime_error("Unix domain sockets are not supported on this platform");
+#endif
+}
+} // namespace SkylineClient
@@ -0,0 +1,22 @@
+#ifndef __CLIENT_UNIX_SOCKET_HH__
+#define __CLIENT_UNIX_SOCKET_HH__
+
+#include "client_socket.hh"
+
+namespace SkylineClient {
+/**
+ * Unix domain socket传输层
+ *
+ * 客户端与服务端在同一台机器时使用，省去TCP协议栈的开销。
+ * Init的address为socket文件路径，port忽略。
+ */
+class ClientUnixSocket : public ClientSocket {
+    public:
+    using ClientSocket::ClientSocket;
+
+    protected:
+    std::unique_ptr<stream_socket> connect();
+};
+}
+
+#endif // __CLIENT_UNIX_SOCKET_HH__
@@ -1,6 +1,8 @@
 #include "controller.hh"
+#include <cstdlib>
 #include <spdlog/spdlog.h>
 #include "../client_action.hh"
+#include "../common/convert.hh"
 #include "../common/logger.hh"
 #include "js_native_api_types.h"
 
@@ -9,10 +11,14 @@ using Logger::logger;
 namespace HTML {
 Napi::FunctionReference *Controller::GetClazz(Napi::Env env) {
   std::vector<Napi::ClassPropertyDescriptor<Controller>> methods;
-  methods.push_back(Napi::InstanceWrap<Controller>::InstanceMethod("mount", &Controller::mount));
-  methods.push_back(Napi::InstanceWrap<Controller>::InstanceMethod("unmount", &Controller::unmount));
+  AddRemoteMethods<Controller>(methods, {
+    {"mount", &Controller::mount},
+    {"unmount", &Controller::unmount},
+  });
   methods.push_back(Napi::InstanceWrap<Controller>::InstanceAccessor("webview", &Controller::getWebview, nullptr, static_cast<napi_property_attributes>(napi_configurable | napi_writable)));
   methods.push_back(Napi::ObjectWrap<Controller>::StaticMethod("connect", &Controller::connect));
+  methods.push_back(Napi::ObjectWrap<Controller>::StaticMethod("transportStats", &Controller::transportStats));
+  methods.push_back(Napi::ObjectWrap<Controller>::StaticMethod("checkEncoding", &Controller::checkEncoding));
 
   Napi::Function func = DefineClass(env, "Controller", methods);
 
@@ -33,28 +39,56 @@ Controller::Controller(const Napi::CallbackInfo &info)
                                "Constructor: Argument 0 must be a function");
   }
   errorCallbackRef = std::make_shared<Napi::FunctionReference>(Napi::Persistent(info[0].As<Napi::Function>()));
-  m_instanceId = sendConstructorToServerSync(info, __func__);
+  ClientAction::onAsyncError(info.Env(), [](Napi::Env env, const std::string &error) {
+    if (errorCallbackRef && !errorCallbackRef->IsEmpty()) {
+      errorCallbackRef->Call({Napi::String::New(env, error)});
+    }
+  });
+  // 不等待服务器，构造请求在下一次同步调用前发出
+  bindInstanceId(sendConstructorToServerAsync(info, __func__));
   logger->info("Controller instanceId: {}", m_instanceId);
 }
 Napi::Value Controller::connect(const Napi::CallbackInfo &info) {
   try {
     auto env = info.Env();
-    std::string address = "127.0.0.1";
+    // 未指定地址时可通过环境变量切换传输层，如 unix:/tmp/skyline.sock
+    auto envAddress = std::getenv("SKYLINE_SERVER_ADDRESS");
+    std::string address = envAddress ? envAddress : "127.0.0.1";
     int port = 3001;
+    SkylineClient::Options options;
     if (info.Length() > 0 && !info[0].IsString()) {
       throw Napi::TypeError::New(env, "connect: Argument 0 must be a string");
     }
     if (info.Length() > 1 && !info[1].IsNumber()) {
       throw Napi::TypeError::New(env, "connect: Argument 1 must be a number");
     }
+    if (info.Length() > 2 && !info[2].IsObject()) {
+      throw Napi::TypeError::New(env, "connect: Argument 2 must be an object");
+    }
     if (info.Length() > 0) {
       address = info[0].As<Napi::String>().Utf8Value();
     }
     if (info.Length() > 1) {
       port = info[1].As<Napi::Number>().Int32Value();
     }
+    if (info.Length() > 2) {
+      // options.codec: "msgpack"(默认) | "cbor" | "json"(调试用)
+      auto jsOptions = info[2].As<Napi::Object>();
+      if (jsOptions.Get("codec").IsString()) {
+        options.codec = Frame::parseCodec(jsOptions.Get("codec").As<Napi::String>().Utf8Value());
+      }
+      // options.sharedMemory: 同机时握手后改走共享内存，服务端不支持则继续用socket
+      if (jsOptions.Get("sharedMemory").IsBoolean()) {
+        options.sharedMemory = jsOptions.Get("sharedMemory").As<Napi::Boolean>().Value();
+      }
+      // options.compressThreshold: 超过该字节数的payload压缩发送，0关闭
+      if (jsOptions.Get("compressThreshold").IsNumber()) {
+        options.compressThreshold = jsOptions.Get("compressThreshold").As<Napi::Number>().Int64Value();
+      }
+    }
 
-    ClientAction::initSocket(address, port);
+    ClientAction::initSocket(address, port, options);
+    ClientAction::startReleaseTimer(env);
     return env.Undefined();
   } catch (const std::exception &e) {
     logger->error("Error in connect: {}", e.what());
@@ -65,8 +99,28 @@ Napi::Value Controller::connect(const Napi::CallbackInfo &info) {
     throw Napi::Error::New(info.Env(), "Unknown error occurred");
   }
 }
+Napi::Value Controller::transportStats(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  try {
+    return Convert::convertJson2Value(env, ClientAction::transportStats());
+  } catch (const std::exception &e) {
+    throw Napi::Error::New(env, e.what());
+  }
+}
+Napi::Value Controller::checkEncoding(const Napi::CallbackInfo &info) {
+  auto env = info.Env();
+  if (info.Length() < 2 || !info[1].IsString()) {
+    throw Napi::TypeError::New(env, "checkEncoding: Argument 1 must be a string");
+  }
+  try {
+    auto codec = Frame::parseCodec(info[1].As<Napi::String>().Utf8Value());
+    return Convert::convertJson2Value(env, ClientAction::checkEncoding(env, info[0], codec));
+  } catch (const std::exception &e) {
+    throw Napi::Error::New(env, e.what());
+  }
+}
 Napi::Value Controller::getWebview(const Napi::CallbackInfo &info) {
-  return getProperty(info, "webview");
+  return getPipelinedProperty(info, "webview", "ChromeWebViewElement");
 }
 Napi::Value Controller::mount(const Napi::CallbackInfo &info) {
   return sendToServerSync(info, __func__);
@@ -16,6 +16,8 @@ private:
   Napi::Value mount(const Napi::CallbackInfo &info);
   Napi::Value unmount(const Napi::CallbackInfo &info);
   static Napi::Value connect(const Napi::CallbackInfo &info);
+  static Napi::Value transportStats(const Napi::CallbackInfo &info);
+  static Napi::Value checkEncoding(const Napi::CallbackInfo &info);
 };
 
 } // namespace HTML
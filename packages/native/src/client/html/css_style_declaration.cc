@@ -4,7 +4,9 @@
 namespace HTML {
 Napi::FunctionReference *CSSStyleDeclaration::GetClazz(Napi::Env env) {
   auto methods = GetCommonMethods<CSSStyleDeclaration>();
-  methods.push_back(Napi::InstanceWrap<CSSStyleDeclaration>::InstanceMethod("setText", &CSSStyleDeclaration::setText));
+  AddRemoteMethods<CSSStyleDeclaration>(methods, {
+    {"setText", &CSSStyleDeclaration::setText},
+  });
   methods.push_back(Napi::InstanceWrap<CSSStyleDeclaration>::InstanceAccessor("display", &CSSStyleDeclaration::getDisplay, &CSSStyleDeclaration::setDisplay, static_cast<napi_property_attributes>(napi_writable | napi_configurable)));
   methods.push_back(Napi::InstanceWrap<CSSStyleDeclaration>::InstanceAccessor("pointerEvents", &CSSStyleDeclaration::getPointerEvents, &CSSStyleDeclaration::setPointerEvents, static_cast<napi_property_attributes>(napi_writable | napi_configurable)));
   Napi::Function func = DefineClass(env, "CSSStyleDeclaration", methods);
@@ -21,7 +23,7 @@ CSSStyleDeclaration::CSSStyleDeclaration(const Napi::CallbackInfo &info)
                                "Constructor: Wrong number of arguments");
   }
 
-  m_instanceId = info[0].As<Napi::Number>().Int64Value();
+  bindInstanceId(info[0].As<Napi::Number>().Int64Value());
 }
 Napi::Value CSSStyleDeclaration::setText(const Napi::CallbackInfo &info) {
   return sendToServerSync(info, __func__);
@@ -30,12 +32,13 @@ Napi::Value CSSStyleDeclaration::getDisplay(const Napi::CallbackInfo &info) {
   return getProperty(info, "display");
 }
 void CSSStyleDeclaration::setDisplay(const Napi::CallbackInfo &info, const Napi::Value &value) {
-  setProperty(info, "display");
+  // 动画和拖拽中每帧可能多次写入，只发送最后一次
+  setPropertyCoalesced(info, "display");
 }
 Napi::Value CSSStyleDeclaration::getPointerEvents(const Napi::CallbackInfo &info) {
   return getProperty(info, "pointerEvents");
 }
 void CSSStyleDeclaration::setPointerEvents(const Napi::CallbackInfo &info, const Napi::Value &value) {
-  setProperty(info, "pointerEvents");
+  setPropertyCoalesced(info, "pointerEvents");
 }
 } // namespace HTML
\ No newline at end of file
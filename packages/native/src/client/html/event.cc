@@ -8,7 +8,9 @@ Napi::FunctionReference *Event::GetClazz(Napi::Env env) {
   methods.push_back(InstanceAccessor("dialog", &Event::getDialog, nullptr, static_cast<napi_property_attributes>(napi_writable | napi_configurable)));
   methods.push_back(InstanceAccessor("messageText", &Event::getMessageText, nullptr, static_cast<napi_property_attributes>(napi_writable | napi_configurable)));
   methods.push_back(InstanceAccessor("messageType", &Event::getMessageType, nullptr, static_cast<napi_property_attributes>(napi_writable | napi_configurable)));
-  methods.push_back(InstanceMethod("preventDefault", &Event::preventDefault, napi_enumerable));
+  AddRemoteMethods<Event>(methods, {
+    {"preventDefault", &Event::preventDefault, napi_enumerable},
+  });
   methods.push_back(InstanceAccessor("returnValue", nullptr, &Event::setReturnValue, static_cast<napi_property_attributes>(napi_writable | napi_configurable)));
   methods.push_back(InstanceAccessor("type", &Event::getType, nullptr, static_cast<napi_property_attributes>(napi_writable | napi_configurable)));
 
@@ -26,7 +28,9 @@ Event::Event(const Napi::CallbackInfo &info)
                                "Constructor: Wrong number of arguments");
   }
 
-  m_instanceId = info[0].As<Napi::Number>().Int64Value();
+  bindInstanceId(info[0].As<Napi::Number>().Int64Value());
+  // 事件处理中通常会依次读取这些字段
+  prefetchProperties({"type", "messageText", "messageType"});
 }
 
 Napi::Value Event::getDialog(const Napi::CallbackInfo &info) {
@@ -10,7 +10,7 @@ ShadowNode::ShadowNode(const Napi::CallbackInfo &info) {
                                "Constructor: Wrong number of arguments");
   }
 
-  m_instanceId = info[0].As<Napi::Number>().Int64Value();
+  bindInstanceId(info[0].As<Napi::Number>().Int64Value());
 }
 
 Napi::Value ShadowNode::reload(const Napi::CallbackInfo &info) {
@@ -10,9 +10,13 @@ namespace HTML {
 template<typename T>
 std::vector<Napi::ClassPropertyDescriptor<T>> GetCommonMethods() {
   std::vector<Napi::ClassPropertyDescriptor<T>> methods;
-  methods.push_back(Napi::InstanceWrap<T>::InstanceMethod("reload", &T::reload));
-  methods.push_back(Napi::InstanceWrap<T>::InstanceMethod("setAttribute", &T::setAttribute, static_cast<napi_property_attributes>(napi_writable | napi_configurable)));
-  methods.push_back(Napi::InstanceWrap<T>::InstanceMethod("removeAttribute", &T::removeAttribute));
+  AddRemoteMethods<T>(methods, {
+    {"reload", &T::reload},
+    {"setAttribute", &T::setAttribute, static_cast<napi_property_attributes>(napi_writable | napi_configurable)},
+    {"removeAttribute", &T::removeAttribute},
+  });
+  methods.push_back(Napi::InstanceWrap<T>::InstanceMethod("getPropertyAsync", &T::getPropertyAsync));
+  methods.push_back(Napi::InstanceWrap<T>::InstanceMethod("getProperties", &T::getProperties));
 
 
   // Add instance accessors
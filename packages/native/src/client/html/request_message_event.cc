@@ -5,13 +5,15 @@
 namespace HTML {
 Napi::FunctionReference *RequestMessageEvent::GetClazz(Napi::Env env) {
   auto methods = GetCommonMethods<RequestMessageEvent>();
-  methods.push_back(InstanceMethod("addListener", &RequestMessageEvent::addListener));
-  methods.push_back(InstanceMethod("dispatch", &RequestMessageEvent::dispatch));
-  methods.push_back(InstanceMethod("dispatchNW", &RequestMessageEvent::dispatchNW));
-  methods.push_back(InstanceMethod("getListeners", &RequestMessageEvent::getListeners));
-  methods.push_back(InstanceMethod("hasListener", &RequestMessageEvent::hasListener));
-  methods.push_back(InstanceMethod("hasListeners", &RequestMessageEvent::hasListeners));
-  methods.push_back(InstanceMethod("removeListener", &RequestMessageEvent::removeListener));
+  AddRemoteMethods<RequestMessageEvent>(methods, {
+    {"addListener", &RequestMessageEvent::addListener},
+    {"dispatch", &RequestMessageEvent::dispatch},
+    {"dispatchNW", &RequestMessageEvent::dispatchNW},
+    {"getListeners", &RequestMessageEvent::getListeners},
+    {"hasListener", &RequestMessageEvent::hasListener},
+    {"hasListeners", &RequestMessageEvent::hasListeners},
+    {"removeListener", &RequestMessageEvent::removeListener},
+  });
 
   Napi::Function func = DefineClass(env, "RequestMessageEvent", methods);
 
@@ -27,7 +29,7 @@ RequestMessageEvent::RequestMessageEvent(const Napi::CallbackInfo &info)
                                "Constructor: Wrong number of arguments");
   }
 
-  m_instanceId = info[0].As<Napi::Number>().Int64Value();
+  bindInstanceId(info[0].As<Napi::Number>().Int64Value());
 }
 Napi::Value RequestMessageEvent::addListener(const Napi::CallbackInfo &info) {
   return sendToServerSync(info, __func__);
@@ -4,9 +4,11 @@
 namespace HTML {
 Napi::FunctionReference *RequestRule::GetClazz(Napi::Env env) {
   auto methods = GetCommonMethods<RequestRule>();
-  methods.push_back(InstanceMethod("getRules", &RequestRule::getRules));
-  methods.push_back(InstanceMethod("addRules", &RequestRule::addRules));
-  methods.push_back(InstanceMethod("removeRules", &RequestRule::removeRules));
+  AddRemoteMethods<RequestRule>(methods, {
+    {"getRules", &RequestRule::getRules},
+    {"addRules", &RequestRule::addRules},
+    {"removeRules", &RequestRule::removeRules},
+  });
   Napi::Function func = DefineClass(env, "RequestRule", methods);
 
   Napi::FunctionReference *constructor = new Napi::FunctionReference();
@@ -21,7 +23,7 @@ RequestRule::RequestRule(const Napi::CallbackInfo &info)
                                "Constructor: Wrong number of arguments");
   }
 
-  m_instanceId = info[0].As<Napi::Number>().Int64Value();
+  bindInstanceId(info[0].As<Napi::Number>().Int64Value());
 }
 
 Napi::Value RequestRule::addRules(const Napi::CallbackInfo &info) {
@@ -5,9 +5,11 @@
 namespace HTML {
 Napi::FunctionReference *WebRequestEvent::GetClazz(Napi::Env env) {
   auto methods = GetCommonMethods<WebRequestEvent>();
-  methods.push_back(InstanceMethod("addListener", &WebRequestEvent::addListener, napi_enumerable));
-  methods.push_back(InstanceMethod("hasListener", &WebRequestEvent::hasListener, napi_enumerable));
-  methods.push_back(InstanceMethod("removeListener", &WebRequestEvent::removeListener, napi_enumerable));
+  AddRemoteMethods<WebRequestEvent>(methods, {
+    {"addListener", &WebRequestEvent::addListener, napi_enumerable},
+    {"hasListener", &WebRequestEvent::hasListener, napi_enumerable},
+    {"removeListener", &WebRequestEvent::removeListener, napi_enumerable},
+  });
 
   Napi::Function func = DefineClass(env, "WebRequestEvent", methods);
 
@@ -22,7 +24,7 @@ WebRequestEvent::WebRequestEvent(const Napi::CallbackInfo &info)
     throw Napi::TypeError::New(info.Env(),
                                "Constructor: Wrong number of arguments");
   }
-  m_instanceId = info[0].As<Napi::Number>().Int64Value();
+  bindInstanceId(info[0].As<Napi::Number>().Int64Value());
 }
 Napi::Value WebRequestEvent::addListener(const Napi::CallbackInfo &info) {
   return sendToServerSync(info, __func__);
@@ -13,12 +13,14 @@ Napi::FunctionReference *WebviewElement::GetClazz(Napi::Env env) {
   methods.push_back(InstanceAccessor("style", &WebviewElement::getStyle, &WebviewElement::setStyle, static_cast<napi_property_attributes>(napi_writable | napi_configurable)));
   methods.push_back(InstanceAccessor("ondialog", nullptr, &WebviewElement::setOndialog, static_cast<napi_property_attributes>(napi_writable | napi_configurable)));
 
-  methods.push_back(InstanceMethod("addEventListener", &WebviewElement::addEventListener, napi_enumerable));
-  methods.push_back(InstanceMethod("executeScript", &WebviewElement::executeScript, napi_enumerable));
-  methods.push_back(InstanceMethod("getAttribute", &WebviewElement::getAttribute, napi_enumerable));
-  methods.push_back(InstanceMethod("getUserAgent", &WebviewElement::getUserAgent, napi_enumerable));
-  methods.push_back(InstanceMethod("removeEventListener", &WebviewElement::removeEventListener, napi_enumerable));
-  methods.push_back(InstanceMethod("setUserAgentOverride", &WebviewElement::setUserAgentOverride, napi_enumerable));
+  AddRemoteMethods<WebviewElement>(methods, {
+    {"addEventListener", &WebviewElement::addEventListener, napi_enumerable},
+    {"executeScript", &WebviewElement::executeScript, napi_enumerable},
+    {"getAttribute", &WebviewElement::getAttribute, napi_enumerable},
+    {"getUserAgent", &WebviewElement::getUserAgent, napi_enumerable},
+    {"removeEventListener", &WebviewElement::removeEventListener, napi_enumerable},
+    {"setUserAgentOverride", &WebviewElement::setUserAgentOverride, napi_enumerable},
+  });
   methods.push_back(InstanceMethod("showDevTools", &WebviewElement::showDevTools, static_cast<napi_property_attributes>(napi_writable | napi_configurable | napi_enumerable)));
   Napi::Function func = DefineClass(env, "WebviewElement", methods);
   Napi::FunctionReference *constructor = new Napi::FunctionReference();
@@ -34,7 +36,7 @@ WebviewElement::WebviewElement(const Napi::CallbackInfo &info)
                                "Constructor: Wrong number of arguments");
   }
 
-  m_instanceId = info[0].As<Napi::Number>().Int64Value();
+  bindInstanceId(info[0].As<Napi::Number>().Int64Value());
 }
 
 Napi::Value WebviewElement::addEventListener(const Napi::CallbackInfo &info) {
@@ -75,7 +77,7 @@ void WebviewElement::setSrc(const Napi::CallbackInfo &info, const Napi::Value &v
 }
 
 Napi::Value WebviewElement::getStyle(const Napi::CallbackInfo &info) {
-  return getProperty(info, "style");
+  return getPipelinedProperty(info, "style", "CSSStyleDeclaration");
 }
 void WebviewElement::setStyle(const Napi::CallbackInfo &info, const Napi::Value &value) {
   setProperty(info, "style");
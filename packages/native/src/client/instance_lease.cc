@@ -0,0 +1,121 @@
+#include "instance_lease.hh"
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace InstanceLease {
+    struct Lease {
+        // 收到服务端发出的引用的次数
+        int64_t imports = 0;
+        // 存活的代理和结果表记录
+        int64_t holders = 0;
+    };
+    static std::unordered_map<int64_t, Lease> leases;
+    // (实例id, 收到次数)，随下一个batch发出
+    static std::vector<std::pair<int64_t, int64_t>> pendingReleases;
+    static int replaying = 0;
+    static uint64_t releasedCount = 0;
+    // 服务端删除的实例由接收线程登记
+    static std::mutex droppedMutex;
+    static std::vector<int64_t> droppedIds;
+    static uint64_t droppedCount = 0;
+
+    void imported(int64_t instanceId) {
+        // 负数为流水线的临时id，由服务端的answer表管理
+        if (instanceId <= 0 || replaying > 0) {
+            return;
+        }
+        leases[instanceId].imports++;
+    }
+
+    void hold(int64_t instanceId) {
+        if (instanceId <= 0) {
+            return;
+        }
+        leases[instanceId].holders++;
+    }
+
+    void unhold(int64_t instanceId) {
+        auto target = leases.find(instanceId);
+        if (target == leases.end()) {
+            return;
+        }
+        if (--target->second.holders > 0) {
+            return;
+        }
+        if (target->second.imports > 0) {
+            pendingReleases.emplace_back(instanceId, target->second.imports);
+        }
+        leases.erase(target);
+    }
+
+    Replay::Replay(bool active) : active(active) {
+        if (active) {
+            replaying++;
+        }
+    }
+
+    Replay::~Replay() {
+        if (active) {
+            replaying--;
+        }
+    }
+
+    nlohmann::json takeReleases(std::vector<int64_t> &released) {
+        if (pendingReleases.empty()) {
+            return nullptr;
+        }
+        nlohmann::json instances = nlohmann::json::array();
+        for (const auto &item : pendingReleases) {
+            instances.push_back({item.first, item.second});
+            released.push_back(item.first);
+        }
+        releasedCount += pendingReleases.size();
+        pendingReleases.clear();
+        return nlohmann::json{
+            {"type", "releaseInstances"},
+            {"data", {
+                {"instances", std::move(instances)},
+            }}
+        };
+    }
+
+    bool hasReleases() {
+        return !pendingReleases.empty();
+    }
+
+    void dropped(const std::vector<int64_t> &instanceIds) {
+        std::lock_guard<std::mutex> lock(droppedMutex);
+        droppedIds.insert(droppedIds.end(), instanceIds.begin(), instanceIds.end());
+    }
+
+    std::vector<int64_t> takeDropped() {
+        std::vector<int64_t> ids;
+        {
+            std::lock_guard<std::mutex> lock(droppedMutex);
+            ids.swap(droppedIds);
+        }
+        for (auto id : ids) {
+            // 仍存活的代理回收时找不到记录，不会再请求释放
+            leases.erase(id);
+        }
+        droppedCount += ids.size();
+        return ids;
+    }
+
+    void clear() {
+        leases.clear();
+        pendingReleases.clear();
+        std::lock_guard<std::mutex> lock(droppedMutex);
+        droppedIds.clear();
+    }
+
+    nlohmann::json stats() {
+        return nlohmann::json{
+            {"live", leases.size()},
+            {"pending", pendingReleases.size()},
+            {"released", releasedCount},
+            {"dropped", droppedCount},
+        };
+    }
+}
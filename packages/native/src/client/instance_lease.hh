@@ -0,0 +1,49 @@
+#ifndef __INSTANCE_LEASE_HH__
+#define __INSTANCE_LEASE_HH__
+#include <cstdint>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace InstanceLease {
+    /**
+     * 客户端对服务端实例的持有情况，决定何时通知服务端释放instanceMap中的实例
+     *
+     * 服务端每发出一次实例引用计一次，客户端每收到一次计一次（imported）；
+     * 代理对象和结果表中的记录是持有者（hold），最后一个持有者释放后，
+     * 连同收到的次数一起排入releaseInstances请求。服务端减去该次数后归零才删除，
+     * 释放请求在途时再次发出的引用不会被误删。
+     * 除dropped外只在JS主线程访问
+     */
+    void imported(int64_t instanceId);
+    void hold(int64_t instanceId);
+    // 代理回收（ObjectWrap finalizer）或记录丢弃时调用
+    void unhold(int64_t instanceId);
+    /**
+     * 重放结果表中的记录时不计收到次数：服务端没有再次发出
+     */
+    class Replay {
+    public:
+        explicit Replay(bool active);
+        ~Replay();
+    private:
+        bool active;
+    };
+    /**
+     * 取出排队的释放，组成一条releaseInstances请求；没有时返回null
+     *
+     * released为本次释放的实例id
+     */
+    nlohmann::json takeReleases(std::vector<int64_t> &released);
+    bool hasReleases();
+    /**
+     * 服务端主动删除的实例，可在接收线程调用；之后不再通知服务端释放
+     */
+    void dropped(const std::vector<int64_t> &instanceIds);
+    // 取出服务端删除的实例id，只在JS主线程调用
+    std::vector<int64_t> takeDropped();
+    // 重新连接后服务端的instanceMap是空的
+    void clear();
+    nlohmann::json stats();
+}
+
+#endif // __INSTANCE_LEASE_HH__
@@ -0,0 +1,112 @@
+#include "method_table.hh"
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace MethodTable {
+    // 下标即编号，顺序不能改变
+    static const std::array<const char *, 8> requestTypes = {
+        "constructor",
+        "static",
+        "dynamic",
+        "dynamicProperty",
+        "dynamicProperties",
+        "releaseAnswer",
+        "intern",
+        "releaseInstances",
+    };
+    static constexpr int kInternType = 6;
+
+    static std::unordered_map<std::string, int64_t> ids;
+    // 尚未发出定义的名字，编号从pendingBase开始连续
+    static std::vector<std::string> pendingNames;
+    static int64_t pendingBase = 0;
+    static uint64_t compacted = 0;
+
+    int typeId(const std::string &type) {
+        for (std::size_t i = 0; i < requestTypes.size(); i++) {
+            if (type == requestTypes[i]) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    int64_t nameId(const std::string &name) {
+        if (auto target = ids.find(name); target != ids.end()) {
+            return target->second;
+        }
+        auto id = static_cast<int64_t>(ids.size());
+        if (pendingNames.empty()) {
+            pendingBase = id;
+        }
+        ids.emplace(name, id);
+        pendingNames.push_back(name);
+        return id;
+    }
+
+    void compact(nlohmann::json &data) {
+        if (!data.is_object()) {
+            return;
+        }
+        auto type = data.find("type");
+        if (type == data.end() || !type->is_string()) {
+            return;
+        }
+        auto id = typeId(type->get<std::string>());
+        // 如callbackReply，不经过服务端的请求分发
+        if (id < 0) {
+            return;
+        }
+        data.erase(type);
+        data["t"] = id;
+        if (auto action = data.find("action"); action != data.end() && action->is_string()) {
+            auto methodId = nameId(action->get<std::string>());
+            data.erase(action);
+            data["m"] = methodId;
+        }
+        if (auto clazz = data.find("clazz"); clazz != data.end() && clazz->is_string()) {
+            auto classId = nameId(clazz->get<std::string>());
+            data.erase(clazz);
+            data["c"] = classId;
+        }
+        auto body = data.find("data");
+        if (body != data.end() && body->is_object()) {
+            if (auto property = body->find("propertyAction"); property != body->end() && property->is_string()) {
+                auto set = property->get<std::string>() == "set";
+                body->erase(property);
+                (*body)["p"] = set ? 1 : 0;
+            }
+        }
+        compacted++;
+    }
+
+    nlohmann::json takeDefinitions() {
+        if (pendingNames.empty()) {
+            return nullptr;
+        }
+        nlohmann::json definitions {
+            {"t", kInternType},
+            {"data", {
+                {"base", pendingBase},
+                {"names", std::move(pendingNames)},
+            }}
+        };
+        pendingNames.clear();
+        return definitions;
+    }
+
+    void clear() {
+        ids.clear();
+        pendingNames.clear();
+        pendingBase = 0;
+    }
+
+    nlohmann::json stats() {
+        return nlohmann::json{
+            {"names", ids.size()},
+            {"compacted", compacted},
+        };
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef __METHOD_TABLE_HH__
+#define __METHOD_TABLE_HH__
+#include <cstdint>
+#include <string>
+#include <nlohmann/json.hpp>
+
+namespace MethodTable {
+    /**
+     * 请求中的类型、类名、方法名替换为整数编号，每帧不再重复这些字符串
+     *
+     * 请求类型的编号固定，与服务端server/method-table.ts中的表一致；
+     * 类名和方法名在本次连接中首次出现时分配编号，定义由takeDefinitions取出，
+     * 必须先于使用它的请求发出。只在JS主线程访问
+     */
+    void compact(nlohmann::json &data);
+    // 请求类型的编号，不在表中时返回-1
+    int typeId(const std::string &type);
+    // 类名/方法名的编号，首次出现时分配
+    int64_t nameId(const std::string &name);
+    /**
+     * 上次调用以来新分配的编号，组成一条intern请求；没有新编号时返回null
+     */
+    nlohmann::json takeDefinitions();
+    // 重新连接后服务端的表是空的
+    void clear();
+    nlohmann::json stats();
+}
+
+#endif // __METHOD_TABLE_HH__
@@ -0,0 +1,138 @@
+#include "result_memo.hh"
+#include "instance_lease.hh"
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace ResultMemo {
+    // 同一实例、同样参数下返回值不变的实例方法
+    static const std::unordered_set<std::string> pureMethods = {
+        "getWindowId",
+        "isTab",
+        "getRootNode",
+        "getHostNode",
+        "getUserAgent",
+    };
+    // 返回值不变的静态调用，"类名.方法名"
+    static const std::unordered_set<std::string> pureStatics = {
+        "SkylineGlobal.userAgent",
+        "SkylineGlobal.features",
+    };
+    // 调用后结果会变化的方法
+    static const std::unordered_map<std::string, std::vector<std::string>> invalidatedBy = {
+        {"setUserAgentOverride", {"getUserAgent"}},
+        {"setAsTab", {"isTab"}},
+    };
+
+    // 目标 -> (方法名 + 参数) -> 结果
+    static std::unordered_map<std::string, std::unordered_map<std::string, nlohmann::json>> entries;
+    static uint64_t hits = 0;
+    static uint64_t misses = 0;
+
+    /**
+     * 记录中引用的实例在记录存在期间不能释放，之后重放时还会用到
+     */
+    static void forEachInstance(const nlohmann::json &value, void (*visit)(int64_t)) {
+        if (value.is_array()) {
+            for (const auto &item : value) {
+                forEachInstance(item, visit);
+            }
+        } else if (value.is_object()) {
+            auto instanceId = value.find("instanceId");
+            if (instanceId != value.end() && instanceId->is_number_integer() && value.contains("instanceType")) {
+                visit(instanceId->get<int64_t>());
+                return;
+            }
+            for (const auto &item : value) {
+                forEachInstance(item, visit);
+            }
+        }
+    }
+
+    static std::string entryKey(const std::string &method, const nlohmann::json &args) {
+        return method + '\0' + args.dump();
+    }
+
+    std::string staticTarget(const std::string &clazz) {
+        return clazz;
+    }
+
+    std::string instanceTarget(int64_t instanceId) {
+        return "#" + std::to_string(instanceId);
+    }
+
+    bool isPure(const std::string &target, const std::string &method) {
+        if (!target.empty() && target[0] == '#') {
+            return pureMethods.count(method) > 0;
+        }
+        return pureStatics.count(target + "." + method) > 0;
+    }
+
+    bool lookup(const std::string &target, const std::string &method, const nlohmann::json &args, nlohmann::json &result) {
+        if (auto instance = entries.find(target); instance != entries.end()) {
+            if (auto entry = instance->second.find(entryKey(method, args)); entry != instance->second.end()) {
+                hits++;
+                result = entry->second;
+                return true;
+            }
+        }
+        misses++;
+        return false;
+    }
+
+    void store(const std::string &target, const std::string &method, const nlohmann::json &args, const nlohmann::json &result) {
+        auto &entry = entries[target][entryKey(method, args)];
+        forEachInstance(result, InstanceLease::hold);
+        forEachInstance(entry, InstanceLease::unhold);
+        entry = result;
+    }
+
+    void invalidateAfter(const std::string &target, const std::string &method) {
+        if (method == "release") {
+            if (auto instance = entries.find(target); instance != entries.end()) {
+                auto removed = std::move(instance->second);
+                entries.erase(instance);
+                for (const auto &entry : removed) {
+                    forEachInstance(entry.second, InstanceLease::unhold);
+                }
+            }
+            return;
+        }
+        auto affected = invalidatedBy.find(method);
+        if (affected == invalidatedBy.end()) {
+            return;
+        }
+        auto instance = entries.find(target);
+        if (instance == entries.end()) {
+            return;
+        }
+        for (const auto &name : affected->second) {
+            // 键以方法名加'\0'开头
+            auto prefix = name + '\0';
+            for (auto it = instance->second.begin(); it != instance->second.end();) {
+                if (it->first.compare(0, prefix.size(), prefix) == 0) {
+                    forEachInstance(it->second, InstanceLease::unhold);
+                    it = instance->second.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    void clear() {
+        entries.clear();
+    }
+
+    nlohmann::json stats() {
+        std::size_t count = 0;
+        for (const auto &instance : entries) {
+            count += instance.second.size();
+        }
+        return nlohmann::json{
+            {"hits", hits},
+            {"misses", misses},
+            {"entries", count},
+        };
+    }
+}
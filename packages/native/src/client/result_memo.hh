@@ -0,0 +1,30 @@
+#ifndef __RESULT_MEMO_HH__
+#define __RESULT_MEMO_HH__
+#include <cstdint>
+#include <string>
+#include <nlohmann/json.hpp>
+
+namespace ResultMemo {
+    /**
+     * 返回值不变的远程调用的结果表
+     *
+     * 哪些方法可以记录由result_memo.cc中的表声明，按(实例, 方法, 参数)保存；
+     * 实例调用release或对应的修改方法后丢弃。只在JS主线程访问
+     */
+    // 静态调用的目标为类名，实例调用为实例id
+    std::string staticTarget(const std::string &clazz);
+    std::string instanceTarget(int64_t instanceId);
+
+    bool isPure(const std::string &target, const std::string &method);
+    bool lookup(const std::string &target, const std::string &method, const nlohmann::json &args, nlohmann::json &result);
+    void store(const std::string &target, const std::string &method, const nlohmann::json &args, const nlohmann::json &result);
+    /**
+     * 调用method后丢弃受影响的记录，release丢弃该实例的全部记录
+     */
+    void invalidateAfter(const std::string &target, const std::string &method);
+    // 重新连接后实例id不再对应原来的对象
+    void clear();
+    nlohmann::json stats();
+}
+
+#endif // __RESULT_MEMO_HH__
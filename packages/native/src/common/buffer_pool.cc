@@ -0,0 +1,171 @@
+#include "buffer_pool.hh"
+#include <algorithm>
+#include <new>
+#include <utility>
+#include "frame.hh"
+
+namespace Frame {
+namespace {
+// 每个等级缓存的总字节数上限
+constexpr std::size_t kClassBudget = 8 * 1024 * 1024;
+constexpr std::size_t kMaxCachedBlocks = 256;
+} // namespace
+
+Buffer::Buffer(Block *block) noexcept : block(block) {}
+
+Buffer::Buffer(const Buffer &other) noexcept : block(other.block) {
+  if (block != nullptr) {
+    block->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+Buffer::Buffer(Buffer &&other) noexcept : block(std::exchange(other.block, nullptr)) {}
+
+Buffer &Buffer::operator=(const Buffer &other) noexcept {
+  if (this != &other) {
+    Buffer copy(other);
+    std::swap(block, copy.block);
+  }
+  return *this;
+}
+
+Buffer &Buffer::operator=(Buffer &&other) noexcept {
+  if (this != &other) {
+    reset();
+    block = std::exchange(other.block, nullptr);
+  }
+  return *this;
+}
+
+Buffer::~Buffer() {
+  reset();
+}
+
+void Buffer::reset() noexcept {
+  if (block != nullptr && block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    BufferPool::shared().release(block);
+  }
+  block = nullptr;
+}
+
+char *Buffer::data() noexcept {
+  return block != nullptr ? block->bytes() : nullptr;
+}
+
+const char *Buffer::data() const noexcept {
+  return block != nullptr ? block->bytes() : nullptr;
+}
+
+std::size_t Buffer::size() const noexcept {
+  return block != nullptr ? block->size : 0;
+}
+
+std::size_t Buffer::capacity() const noexcept {
+  return block != nullptr ? block->capacity : 0;
+}
+
+bool Buffer::empty() const noexcept {
+  return size() == 0;
+}
+
+std::string_view Buffer::view() const noexcept {
+  return block != nullptr ? std::string_view(block->bytes(), block->size) : std::string_view();
+}
+
+void Buffer::truncate(std::size_t size) noexcept {
+  if (block != nullptr && size <= block->size) {
+    block->size = size;
+  }
+}
+
+BufferPool &BufferPool::shared() {
+  static BufferPool *pool = new BufferPool();
+  return *pool;
+}
+
+BufferPool::BufferPool() {
+  for (std::size_t i = 0; i < kClassCount; i++) {
+    const std::size_t classSize = std::size_t(1) << (kMinClassShift + i);
+    classes[i].limit = std::min(kMaxCachedBlocks, std::max<std::size_t>(2, kClassBudget / classSize));
+    classes[i].free.reserve(classes[i].limit);
+  }
+}
+
+Buffer::Block *BufferPool::allocate(std::size_t capacity, uint8_t sizeClass) {
+  void *memory = ::operator new(sizeof(Buffer::Block) + capacity);
+  auto block = new (memory) Buffer::Block();
+  block->sizeClass = sizeClass;
+  block->capacity = capacity;
+  return block;
+}
+
+Buffer BufferPool::acquire(std::size_t size) {
+  acquired.fetch_add(1, std::memory_order_relaxed);
+  const std::size_t needed = size + kReceivePadding;
+  std::size_t index = 0;
+  while (index < kClassCount && (std::size_t(1) << (kMinClassShift + index)) < needed) {
+    index++;
+  }
+  if (index == kClassCount) {
+    unpooled.fetch_add(1, std::memory_order_relaxed);
+    auto block = allocate(needed, kUnpooled);
+    block->size = size;
+    return Buffer(block);
+  }
+
+  Buffer::Block *block = nullptr;
+  {
+    auto &sizeClass = classes[index];
+    std::lock_guard<std::mutex> lock(sizeClass.mutex);
+    if (!sizeClass.free.empty()) {
+      block = sizeClass.free.back();
+      sizeClass.free.pop_back();
+    }
+  }
+  if (block != nullptr) {
+    reused.fetch_add(1, std::memory_order_relaxed);
+    block->refs.store(1, std::memory_order_relaxed);
+  } else {
+    block = allocate(std::size_t(1) << (kMinClassShift + index), static_cast<uint8_t>(index));
+  }
+  block->size = size;
+  return Buffer(block);
+}
+
+Buffer BufferPool::copyOf(std::string_view data) {
+  auto buffer = acquire(data.size());
+  std::copy(data.begin(), data.end(), buffer.data());
+  return buffer;
+}
+
+void BufferPool::release(Buffer::Block *block) noexcept {
+  if (block->sizeClass != kUnpooled) {
+    auto &sizeClass = classes[block->sizeClass];
+    std::lock_guard<std::mutex> lock(sizeClass.mutex);
+    if (sizeClass.free.size() < sizeClass.limit) {
+      sizeClass.free.push_back(block);
+      return;
+    }
+  }
+  block->~Block();
+  ::operator delete(block);
+}
+
+nlohmann::json BufferPool::stats() const {
+  std::size_t cachedBytes = 0;
+  std::size_t cachedBlocks = 0;
+  for (std::size_t i = 0; i < kClassCount; i++) {
+    const auto &sizeClass = classes[i];
+    std::lock_guard<std::mutex> lock(sizeClass.mutex);
+    cachedBlocks += sizeClass.free.size();
+    cachedBytes += sizeClass.free.size() << (kMinClassShift + i);
+  }
+  return nlohmann::json{
+      {"acquired", acquired.load(std::memory_order_relaxed)},
+      {"reused", reused.load(std::memory_order_relaxed)},
+      {"unpooled", unpooled.load(std::memory_order_relaxed)},
+      {"cachedBlocks", cachedBlocks},
+      {"cachedBytes", cachedBytes},
+  };
+}
+} // namespace Frame
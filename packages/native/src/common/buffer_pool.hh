@@ -0,0 +1,97 @@
+#ifndef __BUFFER_POOL_HH__
+#define __BUFFER_POOL_HH__
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace Frame {
+  class BufferPool;
+
+  /**
+   * 接收缓冲区句柄
+   *
+   * 引用计数，复制只增加计数不拷贝内容，最后一个句柄销毁时内存归还给BufferPool。
+   * 复制出的句柄共享同一块内存，交出后只应读取。
+   * 内容不会清零，容量至少比长度多kReceivePadding字节。
+   */
+  class Buffer {
+  public:
+    Buffer() noexcept = default;
+    Buffer(const Buffer &other) noexcept;
+    Buffer(Buffer &&other) noexcept;
+    Buffer &operator=(const Buffer &other) noexcept;
+    Buffer &operator=(Buffer &&other) noexcept;
+    ~Buffer();
+
+    char *data() noexcept;
+    const char *data() const noexcept;
+    std::size_t size() const noexcept;
+    std::size_t capacity() const noexcept;
+    bool empty() const noexcept;
+    std::string_view view() const noexcept;
+    // 缩短长度（如解压后的实际长度），不能超过容量
+    void truncate(std::size_t size) noexcept;
+    void reset() noexcept;
+
+  private:
+    friend class BufferPool;
+    struct Block {
+      std::atomic<uint32_t> refs{1};
+      // 所属的尺寸等级，kUnpooled表示超出最大等级单独分配
+      uint8_t sizeClass = 0;
+      std::size_t capacity = 0;
+      std::size_t size = 0;
+      char *bytes() noexcept { return reinterpret_cast<char *>(this + 1); }
+    };
+    explicit Buffer(Block *block) noexcept;
+
+    Block *block = nullptr;
+  };
+
+  /**
+   * 按2的幂分级的接收缓冲区池
+   *
+   * 接收线程取出、JS线程用完归还，每个等级一把锁；
+   * 每级缓存的块数有上限，超过最大等级的缓冲区直接分配和释放。
+   */
+  class BufferPool {
+  public:
+    // 进程内共享的池，不析构，退出时仍在运行的接收线程可以安全归还
+    static BufferPool &shared();
+
+    // 长度为size的缓冲区，内容未初始化
+    Buffer acquire(std::size_t size);
+    // 拷贝一份已有数据
+    Buffer copyOf(std::string_view data);
+    nlohmann::json stats() const;
+
+  private:
+    friend class Buffer;
+    static constexpr std::size_t kMinClassShift = 8;    // 256B
+    static constexpr std::size_t kMaxClassShift = 22;   // 4MiB
+    static constexpr std::size_t kClassCount = kMaxClassShift - kMinClassShift + 1;
+    static constexpr uint8_t kUnpooled = 0xFF;
+
+    struct SizeClass {
+      mutable std::mutex mutex;
+      std::vector<Buffer::Block *> free;
+      std::size_t limit = 0;
+    };
+
+    BufferPool();
+    static Buffer::Block *allocate(std::size_t capacity, uint8_t sizeClass);
+    void release(Buffer::Block *block) noexcept;
+
+    std::array<SizeClass, kClassCount> classes;
+    std::atomic<uint64_t> acquired{0};
+    std::atomic<uint64_t> reused{0};
+    std::atomic<uint64_t> unpooled{0};
+  };
+}
+
+#endif // __BUFFER_POOL_HH__
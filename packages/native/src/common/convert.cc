@@ -1,9 +1,16 @@
 #include "convert.hh"
 #include "napi.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <nlohmann/json_fwd.hpp>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 #ifdef _SKYLINE_CLIENT_
 #include "../client/html/css_style_declaration.hh"
@@ -14,25 +21,109 @@
 #include "../client/html/request_message_event.hh"
 #include "../client/html/request_rule.hh"
 #include "../client/client_action.hh"
+#include "../client/instance_lease.hh"
 #endif
 
 namespace Convert {
 static int64_t callbackId = 1;
-static std::unordered_map<int64_t, CallbackData> callback;
+// 弱引用：JS不再持有的代理可以回收，回收后由代理的析构通知服务端释放
 static std::unordered_map<int64_t, std::shared_ptr<Napi::ObjectReference>> instanceCache;
 
 static std::unordered_map<std::string, Napi::FunctionReference *> clazzMap;
 
 #ifdef _SKYLINE_CLIENT_
 
-CallbackData * find_callback(int64_t callbackId)
+/**
+ * 回调登记，callbackId -> 回调
+ *
+ * 同一个函数只创建一次tsfn；每次发给服务端计一次登记，服务端回收代理时发送unregister归还，
+ * 归零后删除。接收线程查找时加锁，登记和删除只在JS主线程。
+ */
+struct CallbackEntry {
+  std::shared_ptr<CallbackData> data;
+  int64_t registrations = 0;
+};
+static std::mutex callbackMutex;
+static std::unordered_map<int64_t, CallbackEntry> callback;
+static std::atomic<uint64_t> callbacksCreated{0};
+static std::atomic<uint64_t> callbacksReused{0};
+static std::atomic<uint64_t> callbacksReleased{0};
+// tsfn的finalizer执行后计数，与callbacksCreated的差为仍占用事件循环的tsfn
+static std::atomic<uint64_t> callbacksFinalized{0};
+
+std::shared_ptr<CallbackData> find_callback(int64_t callbackId)
 {
+  std::lock_guard<std::mutex> lock(callbackMutex);
   auto it = callback.find(callbackId);
   if (it != callback.end()) {
-    return &it->second;
+    return it->second.data;
   }
   return nullptr;
 }
+static void registerCallback(Napi::Env &env, Napi::Function func, int64_t cId) {
+  std::lock_guard<std::mutex> lock(callbackMutex);
+  auto &entry = callback[cId];
+  entry.registrations++;
+  if (entry.data) {
+    callbacksReused++;
+    return;
+  }
+  auto tsfn = Napi::ThreadSafeFunction::New(env, func, "Callback", 0, 1, [](Napi::Env) {
+    callbacksFinalized++;
+  });
+  // 最后一个持有者（可能是接收线程）释放tsfn
+  entry.data = std::shared_ptr<CallbackData>(
+    new CallbackData{std::make_shared<Napi::FunctionReference>(Napi::Persistent(func)), tsfn},
+    [](CallbackData *data) {
+      data->tsfn.Release();
+      delete data;
+    });
+  callbacksCreated++;
+}
+void releaseCallback(int64_t callbackId, int64_t count) {
+  std::shared_ptr<CallbackData> data;
+  {
+    std::lock_guard<std::mutex> lock(callbackMutex);
+    auto it = callback.find(callbackId);
+    if (it == callback.end()) {
+      return;
+    }
+    it->second.registrations -= count;
+    if (it->second.registrations > 0) {
+      return;
+    }
+    data = std::move(it->second.data);
+    callback.erase(it);
+  }
+  callbacksReleased++;
+  // 函数引用在JS主线程删除，接收线程可能还持有data，但只会用到tsfn
+  data->funcRef.reset();
+}
+void clearCallbacks() {
+  std::unordered_map<int64_t, CallbackEntry> released;
+  {
+    std::lock_guard<std::mutex> lock(callbackMutex);
+    released.swap(callback);
+  }
+  for (auto &item : released) {
+    item.second.data->funcRef.reset();
+  }
+  callbacksReleased += released.size();
+}
+nlohmann::json callbackStats() {
+  std::size_t live = 0;
+  {
+    std::lock_guard<std::mutex> lock(callbackMutex);
+    live = callback.size();
+  }
+  return nlohmann::json{
+    {"live", live},
+    {"created", callbacksCreated.load()},
+    {"reused", callbacksReused.load()},
+    {"released", callbacksReleased.load()},
+    {"threadsafeFunctions", callbacksCreated.load() - callbacksFinalized.load()},
+  };
+}
 void RegisteInstanceType(Napi::Env &env) {
   // 注册实例类型和对应的构造函数
   clazzMap["CSSStyleDeclaration"] = HTML::CSSStyleDeclaration::GetClazz(env);
@@ -46,12 +137,48 @@ void RegisteInstanceType(Napi::Env &env) {
 }
 #endif
 
+/**
+ * 函数登记为回调，返回callbackId等描述
+ */
+static nlohmann::json convertFunction(Napi::Env &env, Napi::Function func) {
+  nlohmann::json jsonObj;
+  // 生成callbackId，把Function和callbackId绑定在一起，再次发送时沿用
+  int64_t cId = 0;
+  if (auto knownId = func.Get("__callbackId"); knownId.IsNumber()) {
+    cId = knownId.As<Napi::Number>().Int64Value();
+  } else {
+    if (callbackId >= INT64_MAX) {
+      callbackId = 1;
+    }
+    cId = callbackId++;
+    func.Set("__callbackId", Napi::Number::New(env, cId));
+  }
+  auto isAsync = func.Get("__asyncCallback");
+  jsonObj["callbackId"] = cId;
+  jsonObj["asyncCallback"] = isAsync.IsBoolean() && isAsync.As<Napi::Boolean>().Value();
+
+#ifdef _SKYLINE_CLIENT_
+  registerCallback(env, func, cId);
+#endif
+  if (func.Get("__worklet").IsBoolean()) {
+    jsonObj["asString"] = func.Get("asString").As<Napi::String>().Utf8Value();
+    jsonObj["__workletHash"] = func.Get("__workletHash").As<Napi::Number>().Int64Value();
+    jsonObj["__location"] = func.Get("__location").As<Napi::String>().Utf8Value();
+    jsonObj["__worklet"] = func.Get("__worklet").As<Napi::Boolean>().Value();
+    jsonObj["_closure"] = convertValue2Json(env, func.Get("_closure"));
+  }
+  return jsonObj;
+}
 nlohmann::json convertObject2Json(Napi::Env &env, const Napi::Value &value) {
   Napi::Object obj = value.As<Napi::Object>();
   if (obj.Get("instanceId").IsNumber()) {
     nlohmann::json jsonObj;
     jsonObj["instanceId"] =
         obj.Get("instanceId").As<Napi::Number>().Int64Value();
+    // 服务端回复中的实例引用，客户端按instanceType创建代理
+    if (auto instanceType = obj.Get("instanceType"); instanceType.IsString()) {
+      jsonObj["instanceType"] = instanceType.As<Napi::String>().Utf8Value();
+    }
     return jsonObj;
   }
   nlohmann::json jsonObj = nlohmann::json::object();
@@ -75,54 +202,19 @@ nlohmann::json convertValue2Json(Napi::Env &env, const Napi::Value &value) {
   } else if (value.IsBoolean()) {
     return value.As<Napi::Boolean>().Value();
   } else if (value.IsFunction()) {
-    Napi::Function func = value.As<Napi::Function>();
-    nlohmann::json jsonObj;
-    // 生成callbackId，把Function和callbackId绑定在一起
-    if (callbackId >= INT64_MAX) {
-      callbackId = 1;
-    }
-    auto cId = 0;
-    if (func.Get("__callbackId").IsNumber()) {
-      cId = func.Get("__callbackId").As<Napi::Number>().Int64Value();
-    } else {
-      cId = callbackId++;
-      func.Set("__callbackId", Napi::Number::New(env, cId));
-    }
-    bool isAsync = func.Get(Napi::String::New(env, "__asyncCallback")).IsBoolean();
-    if (isAsync) {
-      isAsync = func.Get(Napi::String::New(env, "__asyncCallback")).As<Napi::Boolean>().Value();
-    }
-    jsonObj["callbackId"] = cId;
-    jsonObj["asyncCallback"] = isAsync;
-
-    callback[cId] = {
-      std::make_shared<Napi::FunctionReference>(Napi::Persistent(func)),
-      Napi::ThreadSafeFunction::New(env, func, "Callback", 0, 1)
-    };
-    if (func.Get("__worklet").IsBoolean()) {
-      jsonObj["asString"] = func.Get("asString").As<Napi::String>().Utf8Value();
-      jsonObj["__workletHash"] = func.Get("__workletHash").As<Napi::Number>().Int64Value();
-      jsonObj["__location"] = func.Get("__location").As<Napi::String>().Utf8Value();
-      jsonObj["__worklet"] = func.Get("__worklet").As<Napi::Boolean>().Value();
-      jsonObj["_closure"] = convertValue2Json(env, func.Get("_closure"));
-    }
-    return jsonObj;
+    return convertFunction(env, value.As<Napi::Function>());
   } else if (value.IsBuffer()) {
-    Napi::Buffer<uint8_t> buffer = value.As<Napi::Buffer<uint8_t>>();
-    size_t byteLength = buffer.Length();
-    nlohmann::json jsonArr;
-    for (uint32_t i = 0; i < byteLength; i++) {
-      jsonArr[i] = buffer.Data()[i];
-    }
-    return jsonArr;
+    auto buffer = value.As<Napi::Buffer<uint8_t>>();
+    return nlohmann::json::binary({buffer.Data(), buffer.Data() + buffer.Length()}, kBinaryBuffer);
   } else if (value.IsArrayBuffer()) {
-    Napi::ArrayBuffer arrayBuffer = value.As<Napi::ArrayBuffer>();
-    size_t byteLength = arrayBuffer.ByteLength();
-    nlohmann::json jsonArr;
-    for (uint32_t i = 0; i < byteLength; i++) {
-      jsonArr[i] = static_cast<uint8_t *>(arrayBuffer.Data())[i];
-    }
-    return jsonArr;
+    auto arrayBuffer = value.As<Napi::ArrayBuffer>();
+    auto data = static_cast<uint8_t *>(arrayBuffer.Data());
+    return nlohmann::json::binary({data, data + arrayBuffer.ByteLength()}, kBinaryArrayBuffer);
+  } else if (value.IsTypedArray()) {
+    auto typedArray = value.As<Napi::TypedArray>();
+    auto data = static_cast<uint8_t *>(typedArray.ArrayBuffer().Data()) + typedArray.ByteOffset();
+    return nlohmann::json::binary({data, data + typedArray.ByteLength()},
+                                  kBinaryTypedArray + static_cast<uint8_t>(typedArray.TypedArrayType()));
   } else if (value.IsArray()) {
     Napi::Array arr = value.As<Napi::Array>();
     nlohmann::json jsonArr = nlohmann::json::array();
@@ -136,6 +228,296 @@ nlohmann::json convertValue2Json(Napi::Env &env, const Napi::Value &value) {
   return nlohmann::json();
 }
 
+template <typename Encoder>
+static void encodeValueTo(Napi::Env &env, const Napi::Value &value, Encoder &encoder) {
+  if (value.IsString()) {
+    encoder.string(value.As<Napi::String>().Utf8Value());
+  } else if (value.IsNumber()) {
+    encoder.number(value.As<Napi::Number>().DoubleValue());
+  } else if (value.IsBoolean()) {
+    encoder.boolean(value.As<Napi::Boolean>().Value());
+  } else if (value.IsFunction()) {
+    encoder.json(convertFunction(env, value.As<Napi::Function>()));
+  } else if (value.IsBuffer()) {
+    auto buffer = value.As<Napi::Buffer<uint8_t>>();
+    encoder.binary(buffer.Data(), buffer.Length(), kBinaryBuffer);
+  } else if (value.IsArrayBuffer()) {
+    auto arrayBuffer = value.As<Napi::ArrayBuffer>();
+    encoder.binary(static_cast<uint8_t *>(arrayBuffer.Data()), arrayBuffer.ByteLength(), kBinaryArrayBuffer);
+  } else if (value.IsTypedArray()) {
+    auto typedArray = value.As<Napi::TypedArray>();
+    auto data = static_cast<uint8_t *>(typedArray.ArrayBuffer().Data()) + typedArray.ByteOffset();
+    encoder.binary(data, typedArray.ByteLength(), kBinaryTypedArray + static_cast<uint8_t>(typedArray.TypedArrayType()));
+  } else if (value.IsArray()) {
+    Napi::Array arr = value.As<Napi::Array>();
+    encoder.beginArray();
+    for (uint32_t i = 0; i < arr.Length(); i++) {
+      encodeValueTo(env, arr.Get(i), encoder);
+    }
+    encoder.endArray();
+  } else if (value.IsObject()) {
+    Napi::Object obj = value.As<Napi::Object>();
+    encoder.beginObject();
+    if (auto instanceId = obj.Get("instanceId"); instanceId.IsNumber()) {
+      encoder.key("instanceId");
+      encoder.integer(instanceId.As<Napi::Number>().Int64Value());
+      if (auto instanceType = obj.Get("instanceType"); instanceType.IsString()) {
+        encoder.key("instanceType");
+        encoder.string(instanceType.As<Napi::String>().Utf8Value());
+      }
+      encoder.endObject();
+      return;
+    }
+    Napi::Array propertyNames = obj.GetPropertyNames();
+    for (uint32_t i = 0; i < propertyNames.Length(); i++) {
+      Napi::String key = propertyNames.Get(i).As<Napi::String>();
+      auto k = key.Utf8Value();
+      if (k.length() == 0) {
+        continue;
+      }
+      encoder.key(k);
+      encodeValueTo(env, obj.Get(key), encoder);
+    }
+    encoder.endObject();
+  } else {
+    encoder.null();
+  }
+}
+
+void encodeValue(Napi::Env &env, const Napi::Value &value, Frame::JsonEncoder &encoder) {
+  encodeValueTo(env, value, encoder);
+}
+
+void encodeValue(Napi::Env &env, const Napi::Value &value, Frame::MsgPackEncoder &encoder) {
+  encodeValueTo(env, value, encoder);
+}
+
+/**
+ * 二进制值按subtype还原为ArrayBuffer/Buffer/TypedArray
+ *
+ * owner持有data所在的内存（接收缓冲区或复制出的内容），作为external内存交给JS，
+ * 随JS对象回收；运行时不允许external内存时复制一份。
+ */
+struct ExternalBytes {
+  Frame::Buffer buffer;
+  std::vector<uint8_t> bytes;
+};
+static std::size_t typedArrayElementSize(napi_typedarray_type type) {
+  switch (type) {
+  case napi_int16_array:
+  case napi_uint16_array:
+    return 2;
+  case napi_int32_array:
+  case napi_uint32_array:
+  case napi_float32_array:
+    return 4;
+  case napi_float64_array:
+  case napi_bigint64_array:
+  case napi_biguint64_array:
+    return 8;
+  default:
+    return 1;
+  }
+}
+static Napi::Value createBinary(Napi::Env &env, std::unique_ptr<ExternalBytes> owner, uint8_t *data, std::size_t length, uint64_t subtype) {
+  auto release = [](Napi::Env, void *, ExternalBytes *hint) { delete hint; };
+  std::size_t elementSize = 1;
+  auto type = napi_uint8_array;
+  if (subtype >= kBinaryTypedArray && subtype <= kBinaryTypedArray + napi_biguint64_array) {
+    type = static_cast<napi_typedarray_type>(subtype - kBinaryTypedArray);
+    elementSize = typedArrayElementSize(type);
+    if (length % elementSize != 0) {
+      return env.Undefined();
+    }
+    if (reinterpret_cast<uintptr_t>(data) % elementSize != 0) {
+      // 附件在报文中不一定按元素对齐，复制到对齐的内存
+      owner = std::make_unique<ExternalBytes>(ExternalBytes{Frame::Buffer(), std::vector<uint8_t>(data, data + length)});
+      data = owner->bytes.data();
+    }
+  }
+  if (subtype == kBinaryBuffer) {
+    try {
+      auto buffer = Napi::Buffer<uint8_t>::New(env, data, length, release, owner.get());
+      owner.release();
+      return buffer;
+    } catch (const Napi::Error &) {
+      return Napi::Buffer<uint8_t>::Copy(env, data, length);
+    }
+  }
+  Napi::ArrayBuffer arrayBuffer;
+  try {
+    arrayBuffer = Napi::ArrayBuffer::New(env, data, length, release, owner.get());
+    owner.release();
+  } catch (const Napi::Error &) {
+    arrayBuffer = Napi::ArrayBuffer::New(env, length);
+    std::copy(data, data + length, static_cast<uint8_t *>(arrayBuffer.Data()));
+  }
+  if (subtype >= kBinaryTypedArray && subtype <= kBinaryTypedArray + napi_biguint64_array) {
+    napi_value typedArray;
+    if (napi_create_typedarray(env, type, length / elementSize, arrayBuffer, 0, &typedArray) != napi_ok) {
+      throw Napi::Error::New(env, "Failed to create typed array");
+    }
+    return Napi::Value(env, typedArray);
+  }
+  return arrayBuffer;
+}
+
+/**
+ * 服务端返回的实例引用（{instanceId, instanceType}）转为JS对象
+ */
+static Napi::Value convertInstance(Napi::Env &env, int64_t instanceId, const std::string &instanceType) {
+#ifdef _SKYLINE_CLIENT_
+  if (instanceType == "function") {
+    // 返回值是个函数，如makeShareable
+    return Napi::Function::New(env, [instanceId](const Napi::CallbackInfo &info) {
+      auto env = info.Env();
+      nlohmann::json args = nlohmann::json::array();
+      for (int i = 0; i < info.Length(); i++) {
+        args[i] = convertValue2Json(env, info[i]);
+      }
+      try {
+        auto result = ClientAction::callStaticSync("functionData", std::to_string(instanceId), args);
+        auto returnValue = result["returnValue"];
+        return Convert::convertJson2Value(env, returnValue);
+      } catch (const std::exception &e) {
+        Napi::Error::New(env,
+                         std::string("Error calling function: ") + e.what())
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+      } catch (...) {
+        Napi::Error::New(env, "Unknown error calling function")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+      }
+
+    });
+  }
+#endif
+
+  auto it = clazzMap.find(instanceType);
+  if (it != clazzMap.end()) {
+    try {
+      Napi::FunctionReference *func = it->second;
+#ifdef _SKYLINE_CLIENT_
+      InstanceLease::imported(instanceId);
+#endif
+      // 创建实例
+      // 先到cache找，对象已被回收时重新创建
+      if (auto target = instanceCache.find(instanceId); target != instanceCache.end()) {
+        auto cached = target->second->Value();
+        if (!cached.IsEmpty()) {
+          return cached;
+        }
+        instanceCache.erase(target);
+      }
+      // cache找不到
+      auto result = func->New({Napi::Number::New(env, instanceId)});
+      instanceCache.emplace(instanceId, std::make_shared<Napi::ObjectReference>(Napi::Weak(result)));
+      return result;
+    } catch (const std::exception &e) {
+      Napi::Error::New(env,
+                       std::string("Error creating instance: ") + e.what())
+          .ThrowAsJavaScriptException();
+      return env.Undefined();
+    }
+  }
+  return env.Undefined();
+}
+Napi::Value createInstance(Napi::Env &env, const std::string &instanceType, int64_t instanceId) {
+  auto it = clazzMap.find(instanceType);
+  if (it == clazzMap.end()) {
+    return env.Undefined();
+  }
+  return it->second->New({Napi::Number::New(env, instanceId)});
+}
+void cacheInstance(int64_t instanceId, const Napi::Object &instance) {
+  auto target = instanceCache.find(instanceId);
+  if (target == instanceCache.end()) {
+    instanceCache.emplace(instanceId, std::make_shared<Napi::ObjectReference>(Napi::Weak(instance)));
+  } else if (target->second->Value().IsEmpty()) {
+    target->second = std::make_shared<Napi::ObjectReference>(Napi::Weak(instance));
+  }
+}
+void evictInstance(int64_t instanceId, bool collectedOnly) {
+  auto target = instanceCache.find(instanceId);
+  if (target == instanceCache.end()) {
+    return;
+  }
+  if (collectedOnly && !target->second->Value().IsEmpty()) {
+    return;
+  }
+  instanceCache.erase(target);
+}
+/**
+ * 属性名按Env缓存，同一个名字每次解码都复用同一个JS字符串
+ *
+ * Node-API 10之前不能对字符串创建引用，名字存为一个持久对象的元素，按序号取回。
+ * 返回值的属性名来自固定的几组类型，数量有限；过长的名字或缓存满后不再登记，直接创建。
+ */
+struct KeyCache {
+  // 为keys中的string_view提供存储，deque追加不移动已有元素
+  std::deque<std::string> names;
+  // 名字在holder中的序号
+  std::unordered_map<std::string_view, uint32_t> keys;
+  Napi::ObjectReference holder;
+};
+constexpr std::size_t kMaxInternedKeys = 4096;
+constexpr std::size_t kMaxInternedKeyLength = 64;
+static std::unordered_map<napi_env, KeyCache> keyCaches;
+
+static napi_value internKey(Napi::Env &env, std::string_view key) {
+  auto cache = keyCaches.find(env);
+  if (cache == keyCaches.end()) {
+    cache = keyCaches.emplace(env, KeyCache()).first;
+    cache->second.holder = Napi::Persistent(Napi::Object::New(env));
+    // Env销毁前释放持久引用
+    napi_add_env_cleanup_hook(env, [](void *arg) {
+      keyCaches.erase(static_cast<napi_env>(arg));
+    }, static_cast<napi_env>(env));
+  }
+  auto &keys = cache->second.keys;
+  if (auto it = keys.find(key); it != keys.end()) {
+    return cache->second.holder.Value().Get(it->second);
+  }
+  auto str = Napi::String::New(env, key.data(), key.size());
+  if (key.size() <= kMaxInternedKeyLength && keys.size() < kMaxInternedKeys) {
+    const auto index = static_cast<uint32_t>(keys.size());
+    cache->second.holder.Value().Set(index, str);
+    auto &name = cache->second.names.emplace_back(key);
+    keys.emplace(std::string_view(name), index);
+  }
+  return str;
+}
+
+/**
+ * 对象的属性先收集为描述符，最后一次napi_define_properties创建
+ *
+ * 所有层级共用一个栈：嵌套对象在父对象追加自己的属性之前已经完成并弹出，
+ * 缓冲区扩容到常见深度后不再分配。
+ */
+static std::vector<napi_property_descriptor> propertyStack;
+static constexpr napi_property_attributes kDataProperty =
+    static_cast<napi_property_attributes>(napi_writable | napi_enumerable | napi_configurable);
+
+static void pushProperty(Napi::Env &env, std::string_view key, napi_value value) {
+  propertyStack.push_back({nullptr, internKey(env, key), nullptr, nullptr, nullptr, value, kDataProperty, nullptr});
+}
+// 转换中抛出异常时丢弃本层已收集的属性
+struct PropertyFrame {
+  std::size_t base = propertyStack.size();
+  ~PropertyFrame() { propertyStack.resize(base); }
+};
+static Napi::Object defineObject(Napi::Env &env, std::size_t base) {
+  Napi::Object obj = Napi::Object::New(env);
+  auto count = propertyStack.size() - base;
+  if (count > 0) {
+    if (napi_define_properties(env, obj, count, propertyStack.data() + base) != napi_ok) {
+      throw Napi::Error::New(env, "Failed to define properties");
+    }
+  }
+  return obj;
+}
+
 Napi::Value convertJson2Value(Napi::Env &env, const nlohmann::json &data) {
   if (data.is_null()) {
     return env.Undefined();
@@ -152,70 +534,270 @@ Napi::Value convertJson2Value(Napi::Env &env, const nlohmann::json &data) {
       arr[i] = convertJson2Value(env, data[i]);
     }
     return arr;
+  } else if (data.is_binary()) {
+    const auto &binary = data.get_binary();
+    auto owner = std::make_unique<ExternalBytes>(ExternalBytes{Frame::Buffer(), binary});
+    auto bytes = owner->bytes.data();
+    return createBinary(env, std::move(owner), bytes, binary.size(),
+                        binary.has_subtype() ? binary.subtype() : kBinaryArrayBuffer);
   } else if (data.is_object()) {
-
-#ifdef _SKYLINE_CLIENT_
-    if (data.contains("instanceId") && data.contains("instanceType") &&
-        data["instanceType"].get_ref<const std::string&>() == "function") {
-      // 返回值是个函数，如makeShareable
-      return Napi::Function::New(env, [data](const Napi::CallbackInfo &info) {
-        auto env = info.Env();
-        nlohmann::json args = nlohmann::json::array();
-        for (int i = 0; i < info.Length(); i++) {
-          args[i] = convertValue2Json(env, info[i]);
-        }
-        try {
-          auto result = ClientAction::callStaticSync("functionData", std::to_string(data["instanceId"].get<int64_t>()), args);
-          auto returnValue = result["returnValue"];
-          return Convert::convertJson2Value(env, returnValue);
-        } catch (const std::exception &e) {
-          Napi::Error::New(env,
-                           std::string("Error calling function: ") + e.what())
-              .ThrowAsJavaScriptException();
-          return env.Undefined();
-        } catch (...) {
-          Napi::Error::New(env, "Unknown error calling function")
-              .ThrowAsJavaScriptException();
-          return env.Undefined();
-        }
-
-      });
-    }
-#endif
-
     if (data.contains("instanceId") && data.contains("instanceType")) {
-      const std::string& instanceType = data["instanceType"].get_ref<const std::string&>();
-      auto it = clazzMap.find(instanceType);
-      if (it != clazzMap.end()) {
-        try {
-          Napi::FunctionReference *func = it->second;
-          // 创建实例
-          // 先到cache找
-          auto instanceId = data["instanceId"].get<int64_t>();
-          if (auto target = instanceCache.find(instanceId); target != instanceCache.end()) {
-            return target->second->Value();
-          }
-          // cache找不到
-          auto result = func->New({Napi::Number::New(env, data["instanceId"].get<int64_t>())});
-          auto ref = Napi::Persistent(result);
-          instanceCache.emplace(instanceId, std::make_shared<Napi::ObjectReference>(std::move(ref)) );
-          return result;
-        } catch (const std::exception &e) {
-          Napi::Error::New(env,
-                           std::string("Error creating instance: ") + e.what())
-              .ThrowAsJavaScriptException();
-          return env.Undefined();
-        }
-      }
-      return env.Undefined();
+      return convertInstance(env, data["instanceId"].get<int64_t>(),
+                             data["instanceType"].get_ref<const std::string&>());
     }
-    Napi::Object obj = Napi::Object::New(env);
+    PropertyFrame frame;
     for (auto it = data.begin(); it != data.end(); ++it) {
-      obj.Set(it.key(), convertJson2Value(env, it.value()));
+      auto value = convertJson2Value(env, it.value());
+      pushProperty(env, it.key(), value);
     }
-    return obj;
+    return defineObject(env, frame.base);
   }
   // undefined
   return env.Undefined();
 }
+// message不为空（带附件的帧）时，正文中的附件占位对象直接引用接收缓冲区，键去掉转义
+static Napi::Value convertOnDemand(Napi::Env &env, simdjson::ondemand::value value, const Frame::Message *message) {
+  switch (value.type()) {
+  case simdjson::ondemand::json_type::null:
+    return env.Undefined();
+  case simdjson::ondemand::json_type::string: {
+    std::string_view str = value.get_string();
+    return Napi::String::New(env, str.data(), str.size());
+  }
+  case simdjson::ondemand::json_type::number:
+    return Napi::Number::New(env, value.get_double());
+  case simdjson::ondemand::json_type::boolean:
+    return Napi::Boolean::New(env, value.get_bool());
+  case simdjson::ondemand::json_type::array: {
+    Napi::Array arr = Napi::Array::New(env);
+    uint32_t i = 0;
+    for (auto item : value.get_array()) {
+      arr[i++] = convertOnDemand(env, item.value(), message);
+    }
+    return arr;
+  }
+  case simdjson::ondemand::json_type::object: {
+    // on-demand只能向前读，先收集属性，读完后再判断是否为实例引用
+    PropertyFrame frame;
+    bool hasInstanceId = false;
+    bool hasInstanceType = false;
+    int64_t instanceId = 0;
+    std::string instanceType;
+    bool hasAttachment = false;
+    uint64_t attachment = 0;
+    uint64_t subtype = kBinaryArrayBuffer;
+    for (auto field : value.get_object()) {
+      std::string_view key = field.unescaped_key();
+      auto item = field.value().value();
+      if (message != nullptr && key == Frame::kAttachmentKey && item.type() == simdjson::ondemand::json_type::number) {
+        hasAttachment = true;
+        attachment = item.get_uint64();
+      } else if (hasAttachment && key == "subtype" && item.type() == simdjson::ondemand::json_type::number) {
+        subtype = item.get_uint64();
+      } else if (key == "instanceId" && item.type() == simdjson::ondemand::json_type::number) {
+        hasInstanceId = true;
+        instanceId = item.get_int64();
+        pushProperty(env, key, Napi::Number::New(env, static_cast<double>(instanceId)));
+      } else if (key == "instanceType" && item.type() == simdjson::ondemand::json_type::string) {
+        hasInstanceType = true;
+        instanceType = std::string(std::string_view(item.get_string()));
+        pushProperty(env, key, Napi::String::New(env, instanceType));
+      } else {
+        // 先转换值：嵌套对象会在栈上压入并弹出自己的属性
+        auto converted = convertOnDemand(env, item, message);
+        pushProperty(env, message != nullptr ? Frame::unescapeKey(key) : key, converted);
+      }
+    }
+    if (hasAttachment) {
+      auto bytes = message->attachment(attachment);
+      auto owner = std::make_unique<ExternalBytes>(ExternalBytes{message->buffer(), {}});
+      return createBinary(env, std::move(owner), reinterpret_cast<uint8_t *>(const_cast<char *>(bytes.data())),
+                          bytes.size(), subtype);
+    }
+    if (hasInstanceId && hasInstanceType) {
+      return convertInstance(env, instanceId, instanceType);
+    }
+    return defineObject(env, frame.base);
+  }
+  default:
+    return env.Undefined();
+  }
+}
+Napi::Value convertJson2Value(Napi::Env &env, simdjson::ondemand::value value) {
+  return convertOnDemand(env, value, nullptr);
+}
+Napi::Value convertMessage2Value(Napi::Env &env, Frame::Message &message, const std::string &pointer) {
+  if (!message.isJson()) {
+    return convertJson2Value(env, message.json(pointer));
+  }
+  Frame::Message::Cursor cursor(message);
+  simdjson::ondemand::value value;
+  if (cursor.at(pointer).get(value) != simdjson::SUCCESS) {
+    return env.Undefined();
+  }
+  return convertOnDemand(env, value, message.hasAttachments() ? &message : nullptr);
+}
+
+/**
+ * 按SAX事件直接创建JS值
+ *
+ * 对象的属性同样收集在propertyStack上；attachments不为空（带附件的JSON帧）时
+ * 占位对象换成引用payload的二进制值，键去掉转义
+ */
+class ValueSax {
+public:
+  ValueSax(Napi::Env &env, const Frame::Buffer &payload, const std::vector<std::string_view> *attachments)
+      : env(env), payload(payload), attachments(attachments) {}
+
+  bool null() {
+    return emit(env.Null());
+  }
+  bool boolean(bool value) {
+    return emit(Napi::Boolean::New(env, value));
+  }
+  bool number_integer(int64_t value) {
+    if (value >= 0) {
+      notePlaceholder(static_cast<uint64_t>(value));
+    }
+    return emit(Napi::Number::New(env, static_cast<double>(value)));
+  }
+  bool number_unsigned(uint64_t value) {
+    notePlaceholder(value);
+    return emit(Napi::Number::New(env, static_cast<double>(value)));
+  }
+  bool number_float(double value, const std::string &) {
+    return emit(Napi::Number::New(env, value));
+  }
+  bool string(std::string &value) {
+    return emit(Napi::String::New(env, value));
+  }
+  bool binary(nlohmann::json::binary_t &value) {
+    const uint64_t subtype = value.has_subtype() ? value.subtype() : kBinaryArrayBuffer;
+    auto owner = std::make_unique<ExternalBytes>(ExternalBytes{Frame::Buffer(), std::move(value)});
+    auto bytes = owner->bytes.data();
+    const auto length = owner->bytes.size();
+    return emit(createBinary(env, std::move(owner), bytes, length, subtype));
+  }
+  bool start_object(std::size_t) {
+    Container container;
+    container.base = propertyStack.size();
+    containers.push_back(std::move(container));
+    return true;
+  }
+  bool key(std::string &value) {
+    containers.back().key = std::move(value);
+    return true;
+  }
+  bool end_object() {
+    auto container = std::move(containers.back());
+    containers.pop_back();
+    Napi::Value value;
+    if (container.hasAttachment &&
+        (container.keys == 1 || (container.keys == 2 && container.subtype != UINT64_MAX))) {
+      if (container.attachment >= attachments->size()) {
+        throw std::runtime_error("Attachment index out of range: " + std::to_string(container.attachment));
+      }
+      auto bytes = (*attachments)[container.attachment];
+      auto owner = std::make_unique<ExternalBytes>(ExternalBytes{payload, {}});
+      value = createBinary(env, std::move(owner), reinterpret_cast<uint8_t *>(const_cast<char *>(bytes.data())),
+                           bytes.size(), container.subtype == UINT64_MAX ? kBinaryArrayBuffer : container.subtype);
+    } else {
+      value = defineObject(env, container.base);
+    }
+    propertyStack.resize(container.base);
+    return emit(value);
+  }
+  bool start_array(std::size_t) {
+    Container container;
+    container.array = Napi::Array::New(env);
+    containers.push_back(std::move(container));
+    return true;
+  }
+  bool end_array() {
+    Napi::Value value = containers.back().array;
+    containers.pop_back();
+    return emit(value);
+  }
+  bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &e) {
+    throw std::runtime_error(e.what());
+  }
+
+  Napi::Value result() const {
+    return root;
+  }
+
+private:
+  struct Container {
+    // 数组为空时是对象，属性从propertyStack的base开始
+    Napi::Array array;
+    std::size_t base = 0;
+    std::string key;
+    std::size_t keys = 0;
+    bool hasAttachment = false;
+    uint64_t attachment = 0;
+    uint64_t subtype = UINT64_MAX;
+  };
+
+  // 带附件的帧中记下占位对象的序号和subtype
+  void notePlaceholder(uint64_t value) {
+    if (attachments == nullptr || containers.empty() || !containers.back().array.IsEmpty()) {
+      return;
+    }
+    auto &container = containers.back();
+    if (container.key == Frame::kAttachmentKey) {
+      container.hasAttachment = true;
+      container.attachment = value;
+    } else if (container.key == "subtype") {
+      container.subtype = value;
+    }
+  }
+
+  bool emit(Napi::Value value) {
+    if (containers.empty()) {
+      root = value;
+      return true;
+    }
+    auto &container = containers.back();
+    if (!container.array.IsEmpty()) {
+      container.array.Set(static_cast<uint32_t>(container.keys++), value);
+      return true;
+    }
+    container.keys++;
+    pushProperty(env, attachments != nullptr ? Frame::unescapeKey(container.key) : std::string_view(container.key), value);
+    return true;
+  }
+
+  Napi::Env &env;
+  const Frame::Buffer &payload;
+  const std::vector<std::string_view> *attachments;
+  std::vector<Container> containers;
+  Napi::Value root;
+};
+
+Napi::Value decodeFrame2Value(Napi::Env &env, const Frame::Buffer &payload, uint8_t flags) {
+  PropertyFrame frame;
+  const auto codec = Frame::codecOf(flags);
+  if (codec == Frame::Codec::Json) {
+    auto body = payload.view();
+    std::vector<std::string_view> blobs;
+    const bool attached = Frame::hasAttachments(flags);
+    if (attached) {
+      auto split = Frame::splitAttachments(body);
+      body = split.body;
+      blobs = std::move(split.blobs);
+    }
+    ValueSax sax(env, payload, attached ? &blobs : nullptr);
+    nlohmann::json::sax_parse(body.begin(), body.end(), &sax);
+    return sax.result();
+  }
+  const auto format = codec == Frame::Codec::Cbor ? nlohmann::json::input_format_t::cbor
+                                                  : nlohmann::json::input_format_t::msgpack;
+  auto view = payload.view();
+  auto adapter = nlohmann::detail::input_adapter(view.begin(), view.end());
+  ValueSax sax(env, payload, nullptr);
+  // 与Frame::decode一致，CBOR的tag作为二进制值的subtype
+  nlohmann::detail::binary_reader<nlohmann::json, decltype(adapter), ValueSax>(std::move(adapter), format)
+      .sax_parse(format, &sax, true, nlohmann::json::cbor_tag_handler_t::store);
+  return sax.result();
+}
 } // namespace Convert
\ No newline at end of file
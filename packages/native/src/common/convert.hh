@@ -1,18 +1,65 @@
 #ifndef __CONVERT_HH__
 #define __CONVERT_HH__
 #include <napi.h>
+#include <memory>
 #include <nlohmann/json.hpp>
+#include <simdjson.h>
+#include "frame_message.hh"
+#include "json_encoder.hh"
+#include "msgpack_encoder.hh"
 
 namespace Convert {
+// 二进制值（json::binary）的subtype，决定接收端还原成的JS类型
+constexpr uint8_t kBinaryArrayBuffer = 0;
+constexpr uint8_t kBinaryBuffer = 1;
+// TypedArray为kBinaryTypedArray + napi_typedarray_type
+constexpr uint8_t kBinaryTypedArray = 0x10;
 struct CallbackData {
   std::shared_ptr<Napi::FunctionReference> funcRef;
   Napi::ThreadSafeFunction tsfn;
 };
 nlohmann::json convertValue2Json(Napi::Env &env, const Napi::Value &value);
+// 与convertValue2Json相同的转换，直接写入报文
+void encodeValue(Napi::Env &env, const Napi::Value &value, Frame::JsonEncoder &encoder);
+void encodeValue(Napi::Env &env, const Napi::Value &value, Frame::MsgPackEncoder &encoder);
 Napi::Value convertJson2Value(Napi::Env &env, const nlohmann::json &data);
+// on-demand迭代的JSON值直接转为JS值，不经过nlohmann::json
+Napi::Value convertJson2Value(Napi::Env &env, simdjson::ondemand::value value);
+// 物化消息中pointer指向的值，JSON编码时直接从原始报文转换，附件直接引用接收缓冲区
+Napi::Value convertMessage2Value(Napi::Env &env, Frame::Message &message, const std::string &pointer);
+/**
+ * 服务端使用：帧直接解码为普通JS值，不构建nlohmann::json
+ *
+ * 不按instanceType创建实例（实例类型只在客户端注册），null保持为null，与JSON.parse一致；
+ * 附件直接引用payload
+ */
+Napi::Value decodeFrame2Value(Napi::Env &env, const Frame::Buffer &payload, uint8_t flags);
+// 按类型直接创建实例对象，不查找也不写入缓存；类型未注册时返回undefined
+Napi::Value createInstance(Napi::Env &env, const std::string &instanceType, int64_t instanceId);
+// 已有的实例对象登记到缓存，之后同一id的返回值复用该对象
+void cacheInstance(int64_t instanceId, const Napi::Object &instance);
+/**
+ * 从缓存中移除实例对象，缓存只弱引用对象
+ *
+ * collectedOnly为true时只移除已被回收的对象（代理的finalizer中调用，同一id可能已有新的代理）
+ */
+void evictInstance(int64_t instanceId, bool collectedOnly = false);
 void RegisteInstanceType(Napi::Env &env);
-// find
-CallbackData * find_callback(int64_t callbackId);
+/**
+ * 查找已登记的回调，可在接收线程调用
+ *
+ * 返回的引用保证查找期间tsfn不被释放；funcRef只能在JS主线程使用
+ */
+std::shared_ptr<CallbackData> find_callback(int64_t callbackId);
+/**
+ * 服务端回收了回调代理，count为该代理对应的发送次数，只能在JS主线程调用
+ *
+ * 客户端发出的次数全部被服务端释放后删除登记，释放函数引用和tsfn
+ */
+void releaseCallback(int64_t callbackId, int64_t count);
+// 连接重建后服务端不再持有任何回调，清空登记，只能在JS主线程调用
+void clearCallbacks();
+nlohmann::json callbackStats();
 } // namespace Convert
 
 #endif
\ No newline at end of file
@@ -0,0 +1,384 @@
+#include "frame.hh"
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Frame {
+namespace {
+constexpr int kFlagsShift = 56;
+constexpr uint8_t kCodecMask = 0x03;
+constexpr int kVersionShift = 5;
+constexpr uint8_t kVersionMask = 0x03;
+constexpr uint32_t kCodecMaskAll = (1u << static_cast<uint8_t>(Codec::Json)) |
+                                   (1u << static_cast<uint8_t>(Codec::MsgPack)) |
+                                   (1u << static_cast<uint8_t>(Codec::Cbor));
+constexpr uint32_t kFeatureMask = kSharedMemoryBit | kCompressionBit | kChunkingBit;
+
+void writeBigEndian32(uint8_t *out, uint32_t value) {
+  for (int i = 3; i >= 0; i--) {
+    out[i] = static_cast<uint8_t>(value & 0xFF);
+    value >>= 8;
+  }
+}
+void writeBigEndian64(uint8_t *out, uint64_t value) {
+  for (int i = 7; i >= 0; i--) {
+    out[i] = static_cast<uint8_t>(value & 0xFF);
+    value >>= 8;
+  }
+}
+uint32_t readBigEndian32(const uint8_t *in) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++) {
+    value = (value << 8) | in[i];
+  }
+  return value;
+}
+uint64_t readBigEndian64(const uint8_t *in) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; i++) {
+    value = (value << 8) | in[i];
+  }
+  return value;
+}
+} // namespace
+
+void encodeHeader(uint8_t *out, uint32_t length, int64_t messageId, uint8_t flags) {
+  const uint64_t idAndFlags = (static_cast<uint64_t>(flags) << kFlagsShift) |
+                              (static_cast<uint64_t>(messageId) & static_cast<uint64_t>(kMaxMessageId));
+  writeBigEndian32(out, length);
+  writeBigEndian64(out + sizeof(uint32_t), idAndFlags);
+}
+
+Header decodeHeader(const uint8_t *in) {
+  Header header;
+  header.length = readBigEndian32(in);
+  const uint64_t idAndFlags = readBigEndian64(in + sizeof(uint32_t));
+  header.flags = static_cast<uint8_t>(idAndFlags >> kFlagsShift);
+  header.messageId = static_cast<int64_t>(idAndFlags & static_cast<uint64_t>(kMaxMessageId));
+  return header;
+}
+
+void encodeChunkPrefix(uint8_t *out, uint8_t marks, uint64_t total) {
+  out[0] = marks;
+  writeBigEndian64(out + 1, total);
+}
+
+ChunkPrefix decodeChunkPrefix(const uint8_t *in) {
+  ChunkPrefix prefix;
+  prefix.marks = in[0];
+  prefix.total = readBigEndian64(in + 1);
+  return prefix;
+}
+
+Lane laneOf(std::size_t payloadSize) {
+  return payloadSize > kChunkSize ? Lane::Bulk : Lane::Interactive;
+}
+
+const char *laneName(Lane lane) {
+  return lane == Lane::Bulk ? "bulk" : "interactive";
+}
+
+uint8_t makeFlags(Codec codec) {
+  return static_cast<uint8_t>((kProtocolVersion << kVersionShift) |
+                              (static_cast<uint8_t>(codec) & kCodecMask));
+}
+
+Codec codecOf(uint8_t flags) {
+  return static_cast<Codec>(flags & kCodecMask);
+}
+
+uint8_t versionOf(uint8_t flags) {
+  return static_cast<uint8_t>((flags >> kVersionShift) & kVersionMask);
+}
+
+bool isBatch(uint8_t flags) {
+  return (flags & kBatchFlag) != 0;
+}
+
+bool hasAttachments(uint8_t flags) {
+  return (flags & kAttachmentFlag) != 0;
+}
+
+uint32_t localCapabilities() {
+  return (static_cast<uint32_t>(kProtocolVersion) << 16) | kSharedMemoryBit | kCompressionBit | kChunkingBit |
+         kCodecMaskAll;
+}
+
+Codec negotiateCodec(uint32_t peerCapabilities, Codec preferred) {
+  const uint32_t peerVersion = peerCapabilities >> 16;
+  const uint32_t peerCodecs = peerCapabilities & 0xFF;
+  if (peerVersion != kProtocolVersion) {
+    // 旧版本对端只认识JSON
+    return Codec::Json;
+  }
+  if (peerCodecs & (1u << static_cast<uint8_t>(preferred))) {
+    return preferred;
+  }
+  return Codec::Json;
+}
+
+uint32_t encodeSelection(Codec codec, uint32_t features) {
+  return (static_cast<uint32_t>(kProtocolVersion) << 16) | (features & kFeatureMask) | static_cast<uint8_t>(codec);
+}
+
+Codec decodeSelection(uint32_t selection) {
+  const uint32_t codec = selection & 0xFF;
+  // 先限定范围再移位，损坏的选择字不能造成超宽移位
+  if ((selection >> 16) != kProtocolVersion || codec > static_cast<uint8_t>(Codec::Cbor) ||
+      !(kCodecMaskAll & (1u << codec))) {
+    return Codec::Json;
+  }
+  return static_cast<Codec>(codec);
+}
+
+bool hasSharedMemory(uint32_t word) {
+  return (word >> 16) == kProtocolVersion && (word & kSharedMemoryBit) != 0;
+}
+
+bool hasCompression(uint32_t word) {
+  return (word >> 16) == kProtocolVersion && (word & kCompressionBit) != 0;
+}
+
+bool hasChunking(uint32_t word) {
+  return (word >> 16) == kProtocolVersion && (word & kChunkingBit) != 0;
+}
+
+Codec parseCodec(const std::string &name) {
+  if (name == "json") {
+    return Codec::Json;
+  }
+  if (name == "msgpack") {
+    return Codec::MsgPack;
+  }
+  if (name == "cbor") {
+    return Codec::Cbor;
+  }
+  throw std::invalid_argument("Unknown codec: " + name);
+}
+
+const char *codecName(Codec codec) {
+  switch (codec) {
+  case Codec::Json:
+    return "json";
+  case Codec::MsgPack:
+    return "msgpack";
+  case Codec::Cbor:
+    return "cbor";
+  }
+  return "unknown";
+}
+
+namespace {
+bool containsBinary(const nlohmann::json &data) {
+  if (data.is_binary()) {
+    return true;
+  }
+  if (data.is_structured()) {
+    for (const auto &item : data) {
+      if (containsBinary(item)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// 复制正文，二进制值换成占位对象并记下原值，附件内容不复制
+nlohmann::json extractAttachments(const nlohmann::json &data, std::vector<const nlohmann::json::binary_t *> &blobs) {
+  if (data.is_binary()) {
+    const auto &binary = data.get_binary();
+    nlohmann::json placeholder{{kAttachmentKey, blobs.size()}};
+    if (binary.has_subtype()) {
+      placeholder["subtype"] = binary.subtype();
+    }
+    blobs.push_back(&binary);
+    return placeholder;
+  }
+  if (data.is_object()) {
+    auto result = nlohmann::json::object();
+    for (auto it = data.begin(); it != data.end(); ++it) {
+      auto value = extractAttachments(it.value(), blobs);
+      if (needsEscape(it.key())) {
+        result[escapeKey(it.key())] = std::move(value);
+      } else {
+        result[it.key()] = std::move(value);
+      }
+    }
+    return result;
+  }
+  if (data.is_array()) {
+    auto result = nlohmann::json::array();
+    for (const auto &item : data) {
+      result.push_back(extractAttachments(item, blobs));
+    }
+    return result;
+  }
+  return data;
+}
+} // namespace
+
+std::string encode(const nlohmann::json &data, Codec codec, uint8_t &flags) {
+  flags = makeFlags(codec);
+  if (codec != Codec::Json || !containsBinary(data)) {
+    return encode(data, codec);
+  }
+  std::vector<const nlohmann::json::binary_t *> blobs;
+  auto out = extractAttachments(data, blobs).dump();
+  std::size_t total = out.size() + blobs.size() * sizeof(uint64_t) + sizeof(uint32_t);
+  for (const auto *blob : blobs) {
+    total += blob->size();
+  }
+  out.reserve(total);
+  for (const auto *blob : blobs) {
+    out.append(reinterpret_cast<const char *>(blob->data()), blob->size());
+  }
+  uint8_t word[sizeof(uint64_t)];
+  for (const auto *blob : blobs) {
+    writeBigEndian64(word, blob->size());
+    out.append(reinterpret_cast<const char *>(word), sizeof(uint64_t));
+  }
+  writeBigEndian32(word, static_cast<uint32_t>(blobs.size()));
+  out.append(reinterpret_cast<const char *>(word), sizeof(uint32_t));
+  flags |= kAttachmentFlag;
+  return out;
+}
+
+Attachments splitAttachments(std::string_view payload) {
+  if (payload.size() < sizeof(uint32_t)) {
+    throw std::runtime_error("Attachment trailer truncated");
+  }
+  const auto *end = reinterpret_cast<const uint8_t *>(payload.data() + payload.size());
+  const uint64_t count = readBigEndian32(end - sizeof(uint32_t));
+  const uint64_t trailer = count * sizeof(uint64_t) + sizeof(uint32_t);
+  if (trailer > payload.size()) {
+    throw std::runtime_error("Attachment trailer truncated");
+  }
+  const auto *lengths = end - trailer;
+  const uint64_t available = payload.size() - trailer;
+  uint64_t blobsSize = 0;
+  for (uint64_t i = 0; i < count; i++) {
+    // 逐个与剩余长度比较，长度之和不会溢出
+    const auto length = readBigEndian64(lengths + i * sizeof(uint64_t));
+    if (length > available - blobsSize) {
+      throw std::runtime_error("Attachment size exceeds payload");
+    }
+    blobsSize += length;
+  }
+  Attachments result;
+  result.body = payload.substr(0, payload.size() - trailer - blobsSize);
+  result.blobs.reserve(count);
+  auto offset = result.body.size();
+  for (uint64_t i = 0; i < count; i++) {
+    const auto length = readBigEndian64(lengths + i * sizeof(uint64_t));
+    result.blobs.push_back(payload.substr(offset, length));
+    offset += length;
+  }
+  return result;
+}
+
+bool attachmentOf(const nlohmann::json &placeholder, std::size_t &index, uint64_t &subtype) {
+  if (!placeholder.is_object() || placeholder.size() > 2) {
+    return false;
+  }
+  auto target = placeholder.find(kAttachmentKey);
+  if (target == placeholder.end() || !target->is_number_integer() || target->get<int64_t>() < 0) {
+    return false;
+  }
+  index = target->get<std::size_t>();
+  auto sub = placeholder.find("subtype");
+  subtype = sub != placeholder.end() && sub->is_number_integer() ? sub->get<uint64_t>() : UINT64_MAX;
+  return true;
+}
+
+void restoreAttachments(nlohmann::json &data, const std::vector<std::string_view> &blobs) {
+  std::size_t index = 0;
+  uint64_t subtype = 0;
+  if (attachmentOf(data, index, subtype)) {
+    if (index >= blobs.size()) {
+      throw std::runtime_error("Attachment index out of range: " + std::to_string(index));
+    }
+    const auto *bytes = reinterpret_cast<const uint8_t *>(blobs[index].data());
+    nlohmann::json::binary_t::container_type content(bytes, bytes + blobs[index].size());
+    data = subtype == UINT64_MAX ? nlohmann::json::binary(std::move(content))
+                                 : nlohmann::json::binary(std::move(content), static_cast<nlohmann::json::binary_t::subtype_type>(subtype));
+    return;
+  }
+  if (data.is_object()) {
+    bool escaped = false;
+    for (auto it = data.begin(); it != data.end(); ++it) {
+      restoreAttachments(it.value(), blobs);
+      escaped = escaped || unescapeKey(it.key()).size() != it.key().size();
+    }
+    if (escaped) {
+      auto result = nlohmann::json::object();
+      for (auto it = data.begin(); it != data.end(); ++it) {
+        result[std::string(unescapeKey(it.key()))] = std::move(it.value());
+      }
+      data = std::move(result);
+    }
+  } else if (data.is_array()) {
+    for (auto &item : data) {
+      restoreAttachments(item, blobs);
+    }
+  }
+}
+
+bool needsEscape(std::string_view key) {
+  return !key.empty() && key.front() == '$';
+}
+
+std::string escapeKey(std::string_view key) {
+  std::string result;
+  result.reserve(key.size() + 1);
+  result.push_back('$');
+  result.append(key);
+  return result;
+}
+
+std::string_view unescapeKey(std::string_view key) {
+  return key.size() > 1 && key[0] == '$' && key[1] == '$' ? key.substr(1) : key;
+}
+
+std::string encode(const nlohmann::json &data, Codec codec) {
+  switch (codec) {
+  case Codec::MsgPack: {
+    std::string out;
+    nlohmann::json::to_msgpack(data, nlohmann::detail::output_adapter<char>(out));
+    return out;
+  }
+  case Codec::Cbor: {
+    std::string out;
+    nlohmann::json::to_cbor(data, nlohmann::detail::output_adapter<char>(out));
+    return out;
+  }
+  case Codec::Json:
+  default:
+    return data.dump();
+  }
+}
+
+nlohmann::json decode(std::string_view payload, Codec codec) {
+  switch (codec) {
+  case Codec::MsgPack:
+    return nlohmann::json::from_msgpack(payload.begin(), payload.end());
+  case Codec::Cbor:
+    // 带subtype的二进制值编码为tag
+    return nlohmann::json::from_cbor(payload.begin(), payload.end(), true, true,
+                                     nlohmann::json::cbor_tag_handler_t::store);
+  case Codec::Json:
+  default:
+    return nlohmann::json::parse(payload.begin(), payload.end());
+  }
+}
+
+nlohmann::json decode(std::string_view payload, Codec codec, uint8_t flags) {
+  if (codec != Codec::Json || !hasAttachments(flags)) {
+    return decode(payload, codec);
+  }
+  auto attachments = splitAttachments(payload);
+  auto data = nlohmann::json::parse(attachments.body.begin(), attachments.body.end());
+  restoreAttachments(data, attachments.blobs);
+  return data;
+}
+} // namespace Frame
@@ -0,0 +1,142 @@
+#ifndef __FRAME_HH__
+#define __FRAME_HH__
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+/**
+ * 帧格式（12字节头 + payload）
+ *
+ * | uint32 length | uint64 (flags << 56 | messageId) | payload |
+ *
+ * flags:
+ * * bit 0-1 payload编码（Codec）
+ * * bit 2 batch：payload为多条消息组成的数组，整体按一次投递处理
+ * * bit 3 payload经过压缩（见Frame::Compressor）
+ * * bit 4 分块帧：payload为 | uint8 标记 | uint64 消息总长 | 数据 |，同一消息的分块按顺序到达，
+ *   中间可穿插其他普通帧；其余flags为整条消息的flags
+ * * bit 5-6 协议版本
+ * * bit 7 带附件：JSON正文之后是二进制附件，见Frame::encode
+ */
+namespace Frame {
+  constexpr std::size_t kHeaderSize = sizeof(uint32_t) + sizeof(uint64_t);
+  constexpr uint32_t kHandshakeMagic = 114514;
+  constexpr uint8_t kProtocolVersion = 1;
+  constexpr int64_t kMaxMessageId = (static_cast<int64_t>(1) << 56) - 1;
+  // capabilities/selection 中的可选特性位
+  constexpr uint32_t kSharedMemoryBit = 1u << 8;
+  constexpr uint32_t kCompressionBit = 1u << 9;
+  constexpr uint32_t kChunkingBit = 1u << 10;
+  constexpr uint8_t kBatchFlag = 1u << 2;
+  constexpr uint8_t kCompressedFlag = 1u << 3;
+  constexpr uint8_t kChunkFlag = 1u << 4;
+  constexpr uint8_t kAttachmentFlag = 1u << 7;
+  // 正文中代替二进制值的占位对象：{"$attachment": 序号, "subtype": 子类型}
+  // 带附件的帧中以$开头的键写为$$开头，不会与占位对象混淆
+  constexpr const char *kAttachmentKey = "$attachment";
+
+  // 分块标记
+  constexpr uint8_t kChunkFirst = 1u << 0;
+  constexpr uint8_t kChunkLast = 1u << 1;
+  constexpr std::size_t kChunkPrefixSize = sizeof(uint8_t) + sizeof(uint64_t);
+  // 超过该长度的消息走bulk通道并拆成此大小的分块
+  constexpr std::size_t kChunkSize = 64 * 1024;
+
+  /**
+   * 发送通道
+   *
+   * 小消息（调用、属性读写、回调回复）走interactive，大消息走bulk，
+   * bulk消息分块发送。同一连接上的帧按入队顺序到达，通道只用于统计。
+   */
+  enum class Lane : uint8_t {
+    Interactive = 0,
+    Bulk = 1,
+  };
+  constexpr std::size_t kLaneCount = 2;
+  // 接收缓冲区在消息末尾预留的容量，按需JSON解析要求输入之后还有可读字节，预留后可免去一次拷贝
+  constexpr std::size_t kReceivePadding = 64;
+
+  enum class Codec : uint8_t {
+    Json = 0,
+    MsgPack = 1,
+    Cbor = 2,
+  };
+
+  struct Header {
+    uint32_t length = 0;
+    int64_t messageId = 0;
+    uint8_t flags = 0;
+  };
+
+  struct ChunkPrefix {
+    uint8_t marks = 0;
+    uint64_t total = 0;
+  };
+
+  void encodeHeader(uint8_t *out, uint32_t length, int64_t messageId, uint8_t flags);
+  Header decodeHeader(const uint8_t *in);
+  void encodeChunkPrefix(uint8_t *out, uint8_t marks, uint64_t total);
+  ChunkPrefix decodeChunkPrefix(const uint8_t *in);
+
+  Lane laneOf(std::size_t payloadSize);
+  const char *laneName(Lane lane);
+
+  uint8_t makeFlags(Codec codec);
+  Codec codecOf(uint8_t flags);
+  uint8_t versionOf(uint8_t flags);
+  bool isBatch(uint8_t flags);
+  bool hasAttachments(uint8_t flags);
+
+  /**
+   * 握手：服务端发送 magic + capabilities，客户端回复选定的编码
+   *
+   * capabilities = version << 16 | 支持的编码掩码
+   * selection = version << 16 | 启用的特性位 | 选定的编码
+   * kSharedMemoryBit置位时随后发送共享内存名称
+   */
+  uint32_t localCapabilities();
+  Codec negotiateCodec(uint32_t peerCapabilities, Codec preferred);
+  uint32_t encodeSelection(Codec codec, uint32_t features = 0);
+  Codec decodeSelection(uint32_t selection);
+  // capabilities/selection 是否带对应的特性位
+  bool hasSharedMemory(uint32_t word);
+  bool hasCompression(uint32_t word);
+  bool hasChunking(uint32_t word);
+
+  Codec parseCodec(const std::string &name);
+  const char *codecName(Codec codec);
+
+  std::string encode(const nlohmann::json &data, Codec codec);
+  nlohmann::json decode(std::string_view payload, Codec codec);
+  /**
+   * 编码并给出该帧的flags
+   *
+   * MsgPack/CBOR原生支持二进制值（json::binary）。JSON编码时二进制值作为附件放在正文之后，
+   * 正文中换成占位对象，flags带kAttachmentFlag：
+   * | JSON正文 | 附件0 | 附件1 | ... | uint64 附件长度 × n | uint32 n |
+   * 这样的帧中以$开头的键都多加一个$（escapeKey），解码时去掉。
+   */
+  std::string encode(const nlohmann::json &data, Codec codec, uint8_t &flags);
+  // 带附件的帧还原为json::binary
+  nlohmann::json decode(std::string_view payload, Codec codec, uint8_t flags);
+
+  struct Attachments {
+    std::string_view body;
+    std::vector<std::string_view> blobs;
+  };
+  // 拆分带附件的payload，返回的视图指向payload
+  Attachments splitAttachments(std::string_view payload);
+  // 占位对象对应的附件，不是占位对象时返回false
+  bool attachmentOf(const nlohmann::json &placeholder, std::size_t &index, uint64_t &subtype);
+  // 把正文中的占位对象替换为附件内容，并去掉键的转义
+  void restoreAttachments(nlohmann::json &data, const std::vector<std::string_view> &blobs);
+  // 带附件的帧中以$开头的键需要转义
+  bool needsEscape(std::string_view key);
+  std::string escapeKey(std::string_view key);
+  // $$开头的键去掉一个$，其他键不变
+  std::string_view unescapeKey(std::string_view key);
+}
+
+#endif // __FRAME_HH__
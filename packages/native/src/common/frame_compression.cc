@@ -0,0 +1,123 @@
+#include "frame_compression.hh"
+#include "frame.hh"
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <lz4.h>
+
+namespace Frame {
+namespace {
+constexpr std::size_t kRawSizeLength = sizeof(uint32_t);
+// 防止损坏的长度前缀导致超大分配
+constexpr uint32_t kMaxInflatedSize = 1u << 30;
+
+void writeSize(char *out, uint32_t value) {
+  for (int i = 3; i >= 0; i--) {
+    out[i] = static_cast<char>(value & 0xFF);
+    value >>= 8;
+  }
+}
+uint32_t readSize(const char *in) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++) {
+    value = (value << 8) | static_cast<uint8_t>(in[i]);
+  }
+  return value;
+}
+} // namespace
+
+Compressor::Compressor(std::size_t threshold) : compressThreshold(threshold) {}
+
+std::size_t Compressor::thresholdFromEnv() {
+  auto value = std::getenv("SKYLINE_COMPRESS_THRESHOLD");
+  if (value == nullptr || *value == '\0') {
+    return kDefaultCompressThreshold;
+  }
+  try {
+    return static_cast<std::size_t>(std::stoull(value));
+  } catch (const std::exception &) {
+    return kDefaultCompressThreshold;
+  }
+}
+
+void Compressor::setEnabled(bool value) {
+  isEnabled.store(value && compressThreshold > 0, std::memory_order_release);
+}
+
+bool Compressor::enabled() const {
+  return isEnabled.load(std::memory_order_acquire);
+}
+
+std::size_t Compressor::threshold() const {
+  return compressThreshold;
+}
+
+void Compressor::deflate(std::string &message, uint8_t &flags) {
+  if (!enabled() || message.size() < compressThreshold || message.size() > static_cast<std::size_t>(LZ4_MAX_INPUT_SIZE)) {
+    return;
+  }
+  const int rawSize = static_cast<int>(message.size());
+  std::string out(kRawSizeLength + LZ4_compressBound(rawSize), '\0');
+  const int size = LZ4_compress_default(message.data(), out.data() + kRawSizeLength, rawSize,
+                                        static_cast<int>(out.size() - kRawSizeLength));
+  // 压缩收益不足1/8时直接发送原文，省掉对端的解压
+  if (size <= 0 || kRawSizeLength + size > message.size() - message.size() / 8) {
+    return;
+  }
+  writeSize(out.data(), static_cast<uint32_t>(rawSize));
+  out.resize(kRawSizeLength + size);
+  framesSent.fetch_add(1, std::memory_order_relaxed);
+  bytesSentRaw.fetch_add(message.size(), std::memory_order_relaxed);
+  bytesSentCompressed.fetch_add(out.size(), std::memory_order_relaxed);
+  message.swap(out);
+  flags |= kCompressedFlag;
+}
+
+Buffer Compressor::inflate(const char *data, std::size_t size, uint8_t &flags) {
+  if (size < kRawSizeLength) {
+    throw std::runtime_error("Compressed frame too short");
+  }
+  const uint32_t rawSize = readSize(data);
+  if (rawSize > kMaxInflatedSize) {
+    throw std::runtime_error("Compressed frame too large: " + std::to_string(rawSize));
+  }
+  auto message = BufferPool::shared().acquire(rawSize);
+  const int written = LZ4_decompress_safe(data + kRawSizeLength, message.data(),
+                                          static_cast<int>(size - kRawSizeLength), static_cast<int>(rawSize));
+  if (written < 0 || static_cast<uint32_t>(written) != rawSize) {
+    throw std::runtime_error("Corrupted compressed frame");
+  }
+  framesReceived.fetch_add(1, std::memory_order_relaxed);
+  bytesReceivedRaw.fetch_add(rawSize, std::memory_order_relaxed);
+  bytesReceivedCompressed.fetch_add(size, std::memory_order_relaxed);
+  flags &= static_cast<uint8_t>(~kCompressedFlag);
+  return message;
+}
+
+std::vector<char> &Compressor::receiveBuffer() {
+  return buffer;
+}
+
+nlohmann::json Compressor::stats() const {
+  const uint64_t sentRaw = bytesSentRaw.load(std::memory_order_relaxed);
+  const uint64_t sentCompressed = bytesSentCompressed.load(std::memory_order_relaxed);
+  const uint64_t receivedRaw = bytesReceivedRaw.load(std::memory_order_relaxed);
+  const uint64_t receivedCompressed = bytesReceivedCompressed.load(std::memory_order_relaxed);
+  return nlohmann::json{
+      {"enabled", enabled()},
+      {"threshold", compressThreshold},
+      {"sent", {
+          {"frames", framesSent.load(std::memory_order_relaxed)},
+          {"rawBytes", sentRaw},
+          {"compressedBytes", sentCompressed},
+          {"bytesSaved", sentRaw - sentCompressed},
+      }},
+      {"received", {
+          {"frames", framesReceived.load(std::memory_order_relaxed)},
+          {"rawBytes", receivedRaw},
+          {"compressedBytes", receivedCompressed},
+          {"bytesSaved", receivedRaw - receivedCompressed},
+      }},
+  };
+}
+} // namespace Frame
@@ -0,0 +1,55 @@
+#ifndef __FRAME_COMPRESSION_HH__
+#define __FRAME_COMPRESSION_HH__
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "buffer_pool.hh"
+
+namespace Frame {
+  // 默认压缩阈值，可通过环境变量 SKYLINE_COMPRESS_THRESHOLD 覆盖，0表示关闭
+  constexpr std::size_t kDefaultCompressThreshold = 64 * 1024;
+
+  /**
+   * 帧压缩（LZ4）
+   *
+   * 握手双方都支持且本端阈值非0时启用，超过阈值的payload压缩后置kCompressedFlag。
+   * 压缩后的payload：| uint32 原始长度 | LZ4 block |
+   * 每个连接一个实例，同时统计收发两个方向节省的字节数。
+   */
+  class Compressor {
+  public:
+    explicit Compressor(std::size_t threshold = kDefaultCompressThreshold);
+
+    // 读取 SKYLINE_COMPRESS_THRESHOLD，未设置时返回默认值
+    static std::size_t thresholdFromEnv();
+
+    void setEnabled(bool value);
+    bool enabled() const;
+    std::size_t threshold() const;
+
+    // 超过阈值且有收益时原地替换为压缩结果并置位flags，可在多个线程调用
+    void deflate(std::string &message, uint8_t &flags);
+    // 解压缩kCompressedFlag帧到池中的缓冲区并清除该位，只在接收线程调用
+    Buffer inflate(const char *data, std::size_t size, uint8_t &flags);
+    // 接收线程读取压缩帧时复用的缓冲区
+    std::vector<char> &receiveBuffer();
+
+    nlohmann::json stats() const;
+
+  private:
+    std::size_t compressThreshold;
+    std::atomic<bool> isEnabled{false};
+    std::vector<char> buffer;
+    std::atomic<uint64_t> framesSent{0};
+    std::atomic<uint64_t> bytesSentRaw{0};
+    std::atomic<uint64_t> bytesSentCompressed{0};
+    std::atomic<uint64_t> framesReceived{0};
+    std::atomic<uint64_t> bytesReceivedRaw{0};
+    std::atomic<uint64_t> bytesReceivedCompressed{0};
+  };
+}
+
+#endif // __FRAME_COMPRESSION_HH__
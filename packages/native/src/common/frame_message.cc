@@ -0,0 +1,242 @@
+#include "frame_message.hh"
+#include <string_view>
+#include <utility>
+
+namespace Frame {
+static_assert(kReceivePadding >= simdjson::SIMDJSON_PADDING, "receive padding too small for simdjson");
+
+namespace {
+// 本线程复用的on-demand解析器
+thread_local simdjson::ondemand::parser threadParser;
+thread_local bool threadParserBusy = false;
+} // namespace
+
+Message::Cursor::Cursor(const Message &message) {
+  if (threadParserBusy) {
+    owned = std::make_unique<simdjson::ondemand::parser>();
+    parser = owned.get();
+  } else {
+    threadParserBusy = true;
+    parser = &threadParser;
+  }
+  if (!message.payload.empty()) {
+    document = parser->iterate(message.view());
+    ready = true;
+  }
+}
+
+Message::Cursor::~Cursor() {
+  if (!owned) {
+    threadParserBusy = false;
+  }
+}
+
+simdjson::ondemand::document &Message::Cursor::root() {
+  return document;
+}
+
+simdjson::simdjson_result<simdjson::ondemand::value> Message::Cursor::at(const std::string &pointer) {
+  if (!ready) {
+    return simdjson::EMPTY;
+  }
+  if (pointer.empty()) {
+    return document.get_value();
+  }
+  return document.at_pointer(pointer);
+}
+
+Message::Message(Buffer &&payload, Codec codec, uint8_t flags) : payload(std::move(payload)), payloadCodec(codec) {
+  if (payloadCodec == Codec::Json && this->payload.capacity() < this->payload.size() + simdjson::SIMDJSON_PADDING) {
+    // BufferPool分配的缓冲区已预留padding，不会走到这里
+    this->payload = BufferPool::shared().copyOf(this->payload.view());
+  }
+  bodySize = this->payload.size();
+  if (payloadCodec == Codec::Json && Frame::hasAttachments(flags)) {
+    // 正文之后的附件和长度表可以充当simdjson要求的padding
+    auto split = splitAttachments(this->payload.view());
+    bodySize = split.body.size();
+    attachments = std::move(split.blobs);
+    attached = true;
+  }
+}
+
+std::string_view Message::attachment(std::size_t index) const {
+  return index < attachments.size() ? attachments[index] : std::string_view();
+}
+
+const Buffer &Message::buffer() const {
+  return payload;
+}
+
+Codec Message::codec() const {
+  return payloadCodec;
+}
+
+std::size_t Message::size() const {
+  return payload.size();
+}
+
+bool Message::isJson() const {
+  return payloadCodec == Codec::Json;
+}
+
+bool Message::hasAttachments() const {
+  return attached;
+}
+
+simdjson::padded_string_view Message::view() const {
+  return simdjson::padded_string_view(payload.data(), bodySize, payload.capacity());
+}
+
+const nlohmann::json &Message::document() {
+  if (!decoded) {
+    decoded = std::make_unique<nlohmann::json>(decode(payload.view(), payloadCodec));
+  }
+  return *decoded;
+}
+
+const Message::Route &Message::route() {
+  if (routed) {
+    return *routed;
+  }
+  auto route = std::make_unique<Route>();
+  if (!isJson()) {
+    const auto &json = document();
+    if (json.is_object()) {
+      route->isObject = true;
+      if (auto it = json.find("type"); it != json.end() && it->is_string()) {
+        route->type = it->get<std::string>();
+      }
+      if (auto it = json.find("callbackId"); it != json.end() && it->is_number()) {
+        route->callbackId = it->get<int64_t>();
+      }
+      if (auto it = json.find("error"); it != json.end()) {
+        route->hasError = true;
+        route->error = it->is_string() ? it->get<std::string>() : it->dump();
+      }
+      if (auto data = json.find("data"); data != json.end() && data->is_object()) {
+        if (auto block = data->find("block"); block != data->end() && block->is_boolean()) {
+          route->block = block->get<bool>();
+        }
+      }
+    }
+    routed = std::move(route);
+    return *routed;
+  }
+
+  if (payload.empty()) {
+    routed = std::move(route);
+    return *routed;
+  }
+  Cursor cursor(*this);
+  simdjson::ondemand::object object;
+  if (cursor.root().get_object().get(object) == simdjson::SUCCESS) {
+    route->isObject = true;
+    // 只读需要的字段，其余字段由迭代器直接跳过
+    for (auto field : object) {
+      std::string_view key = field.unescaped_key();
+      auto value = field.value();
+      if (key == "type") {
+        std::string_view type;
+        if (value.get_string().get(type) == simdjson::SUCCESS) {
+          route->type = std::string(type);
+        }
+      } else if (key == "callbackId") {
+        int64_t callbackId = 0;
+        if (value.get_int64().get(callbackId) == simdjson::SUCCESS) {
+          route->callbackId = callbackId;
+        }
+      } else if (key == "error") {
+        route->hasError = true;
+        std::string_view error;
+        if (value.get_string().get(error) == simdjson::SUCCESS) {
+          route->error = std::string(error);
+        } else {
+          route->error = toJson(value.value()).dump();
+        }
+      } else if (key == "data") {
+        simdjson::ondemand::object data;
+        if (value.get_object().get(data) != simdjson::SUCCESS) {
+          continue;
+        }
+        for (auto item : data) {
+          if (item.unescaped_key().value() == "block") {
+            bool block = true;
+            if (item.value().get_bool().get(block) == simdjson::SUCCESS) {
+              route->block = block;
+            }
+          }
+        }
+      }
+    }
+  }
+  routed = std::move(route);
+  return *routed;
+}
+
+nlohmann::json Message::json(const std::string &pointer) {
+  if (!isJson()) {
+    const auto &json = document();
+    if (pointer.empty()) {
+      return json;
+    }
+    const nlohmann::json::json_pointer path(pointer);
+    return json.contains(path) ? json.at(path) : nlohmann::json();
+  }
+  if (pointer.empty()) {
+    auto result = nlohmann::json::parse(payload.view().substr(0, bodySize));
+    if (attached) {
+      restoreAttachments(result, attachments);
+    }
+    return result;
+  }
+  if (payload.empty()) {
+    return nlohmann::json();
+  }
+  Cursor cursor(*this);
+  simdjson::ondemand::value value;
+  if (cursor.at(pointer).get(value) != simdjson::SUCCESS) {
+    return nlohmann::json();
+  }
+  auto result = toJson(value);
+  if (attached) {
+    restoreAttachments(result, attachments);
+  }
+  return result;
+}
+
+nlohmann::json toJson(simdjson::ondemand::value value) {
+  switch (value.type()) {
+  case simdjson::ondemand::json_type::object: {
+    auto result = nlohmann::json::object();
+    for (auto field : value.get_object()) {
+      std::string key(field.unescaped_key().value());
+      result[std::move(key)] = toJson(field.value());
+    }
+    return result;
+  }
+  case simdjson::ondemand::json_type::array: {
+    auto result = nlohmann::json::array();
+    for (auto item : value.get_array()) {
+      result.push_back(toJson(item.value()));
+    }
+    return result;
+  }
+  case simdjson::ondemand::json_type::string:
+    return std::string(value.get_string().value());
+  case simdjson::ondemand::json_type::boolean:
+    return value.get_bool().value();
+  case simdjson::ondemand::json_type::number:
+    switch (value.get_number_type()) {
+    case simdjson::ondemand::number_type::signed_integer:
+      return value.get_int64().value();
+    case simdjson::ondemand::number_type::unsigned_integer:
+      return value.get_uint64().value();
+    default:
+      return value.get_double().value();
+    }
+  default:
+    return nullptr;
+  }
+}
+} // namespace Frame
@@ -0,0 +1,100 @@
+#ifndef __FRAME_MESSAGE_HH__
+#define __FRAME_MESSAGE_HH__
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <simdjson.h>
+#include "buffer_pool.hh"
+#include "frame.hh"
+
+namespace Frame {
+  /**
+   * 收到的一帧消息，按需解析
+   *
+   * 分发只需要顶层的type/callbackId/error和data.block，route只读这几个字段；
+   * data.args、result等大字段在真正使用时才物化。
+   * JSON编码使用simdjson on-demand，其余字段跳过不解析；
+   * MsgPack/CBOR没有按需解析的方式，首次访问时整体解码一次并缓存。
+   *
+   * 不是线程安全的，同一时刻只能由一个线程访问。
+   */
+  class Message {
+  public:
+    struct Route {
+      // 顶层是否为对象
+      bool isObject = false;
+      std::string type;
+      int64_t callbackId = 0;
+      // data.block，缺省为true
+      bool block = true;
+      bool hasError = false;
+      std::string error;
+    };
+
+    Message() = default;
+    // flags带kAttachmentFlag时正文之后是二进制附件
+    Message(Buffer &&payload, Codec codec, uint8_t flags = 0);
+
+    Codec codec() const;
+    std::size_t size() const;
+    bool isJson() const;
+    // JSON正文带附件表：其中有占位对象，以$开头的键经过转义
+    bool hasAttachments() const;
+    const Route &route();
+    /**
+     * 物化pointer（RFC 6901，如"/data/args"）指向的值，不存在时返回null
+     */
+    nlohmann::json json(const std::string &pointer = "");
+    // 解码后的完整文档，只用于非JSON编码
+    const nlohmann::json &document();
+    /**
+     * JSON正文中{"$attachment": i}对应的附件内容，指向payload，不存在时返回空视图
+     *
+     * 需要在Message之外保留时复制payload()句柄，不必复制内容
+     */
+    std::string_view attachment(std::size_t index) const;
+    const Buffer &buffer() const;
+
+    /**
+     * JSON编码时对消息的一次on-demand迭代，供直接转换为其他表示（如Napi）使用
+     *
+     * 优先复用本线程的解析器；迭代过程中再次进入（如转换时触发了新的同步调用）则另建解析器。
+     * 返回的值在Cursor销毁前有效。
+     */
+    class Cursor {
+    public:
+      explicit Cursor(const Message &message);
+      ~Cursor();
+      Cursor(const Cursor &) = delete;
+      Cursor &operator=(const Cursor &) = delete;
+      simdjson::simdjson_result<simdjson::ondemand::value> at(const std::string &pointer);
+      simdjson::ondemand::document &root();
+
+    private:
+      std::unique_ptr<simdjson::ondemand::parser> owned;
+      simdjson::ondemand::parser *parser;
+      simdjson::ondemand::document document;
+      bool ready = false;
+    };
+
+  private:
+    simdjson::padded_string_view view() const;
+
+    Buffer payload;
+    Codec payloadCodec = Codec::Json;
+    // 带附件时正文的长度和各附件的位置
+    std::size_t bodySize = 0;
+    bool attached = false;
+    std::vector<std::string_view> attachments;
+    std::unique_ptr<Route> routed;
+    std::unique_ptr<nlohmann::json> decoded;
+  };
+
+  // simdjson on-demand值转为nlohmann::json
+  nlohmann::json toJson(simdjson::ondemand::value value);
+}
+
+#endif // __FRAME_MESSAGE_HH__
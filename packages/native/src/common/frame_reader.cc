@@ -0,0 +1,136 @@
+#include "frame_reader.hh"
+#include <array>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace Frame {
+namespace {
+// 防止损坏的长度导致超大分配，默认16GiB
+constexpr uint64_t kDefaultMaxMessageSize = 16ull << 30;
+} // namespace
+
+Reader::Reader(boost::asio::generic::stream_protocol::socket &socket, Compressor &compressor)
+    : socket(socket), compressor(compressor), maxMessageSize(maxMessageSizeFromEnv()) {}
+
+uint64_t Reader::maxMessageSizeFromEnv() {
+  auto value = std::getenv("SKYLINE_MAX_MESSAGE_SIZE");
+  if (value == nullptr || *value == '\0') {
+    return kDefaultMaxMessageSize;
+  }
+  try {
+    return std::stoull(value);
+  } catch (const std::exception &) {
+    return kDefaultMaxMessageSize;
+  }
+}
+
+void Reader::setStreamConsumer(std::shared_ptr<StreamConsumer> value) {
+  consumer = std::move(value);
+}
+
+Buffer Reader::read(int64_t *messageId, uint8_t *flags) {
+  while (true) {
+    std::array<uint8_t, kHeaderSize> headerBytes{};
+    boost::asio::read(socket, boost::asio::buffer(headerBytes.data(), headerBytes.size()));
+    const auto header = decodeHeader(headerBytes.data());
+
+    if (header.flags & kChunkFlag) {
+      if (!readChunk(header)) {
+        continue;
+      }
+      uint8_t frameFlags = static_cast<uint8_t>(assemblingFlags & ~kChunkFlag);
+      if (messageId != nullptr) {
+        *messageId = assemblingId;
+      }
+      auto message = finish(std::move(assembling), frameFlags);
+      assembled = 0;
+      if (flags != nullptr) {
+        *flags = frameFlags;
+      }
+      return message;
+    }
+
+    uint8_t frameFlags = header.flags;
+    if (messageId != nullptr) {
+      *messageId = header.messageId;
+    }
+    Buffer message;
+    if (frameFlags & kCompressedFlag) {
+      // 压缩数据读进复用的缓冲区，只为解压结果分配
+      auto &buffer = compressor.receiveBuffer();
+      buffer.resize(header.length);
+      boost::asio::read(socket, boost::asio::buffer(buffer.data(), header.length));
+      message = compressor.inflate(buffer.data(), header.length, frameFlags);
+    } else {
+      message = BufferPool::shared().acquire(header.length);
+      boost::asio::read(socket, boost::asio::buffer(message.data(), header.length));
+    }
+    if (flags != nullptr) {
+      *flags = frameFlags;
+    }
+    return message;
+  }
+}
+
+bool Reader::readChunk(const Header &header) {
+  if (header.length < kChunkPrefixSize) {
+    throw std::runtime_error("Chunk frame too short");
+  }
+  std::array<uint8_t, kChunkPrefixSize> prefixBytes{};
+  boost::asio::read(socket, boost::asio::buffer(prefixBytes.data(), prefixBytes.size()));
+  const auto prefix = decodeChunkPrefix(prefixBytes.data());
+  const std::size_t length = header.length - kChunkPrefixSize;
+
+  if (prefix.marks & kChunkFirst) {
+    if ((maxMessageSize != 0 && prefix.total > maxMessageSize) ||
+        prefix.total > std::numeric_limits<std::size_t>::max()) {
+      throw std::runtime_error("Chunked message too large: " + std::to_string(prefix.total));
+    }
+    total = prefix.total;
+    assembled = 0;
+    assemblingId = header.messageId;
+    assemblingFlags = header.flags;
+    const auto messageFlags = static_cast<uint8_t>(header.flags & ~kChunkFlag);
+    streaming = consumer && !(messageFlags & kCompressedFlag) &&
+                consumer->begin(header.messageId, messageFlags, prefix.total);
+    if (!streaming) {
+      // 按总长一次分配，后续分块直接读到目标位置
+      assembling = BufferPool::shared().acquire(static_cast<std::size_t>(prefix.total));
+    }
+  } else if (header.messageId != assemblingId || total != prefix.total) {
+    throw std::runtime_error("Unexpected chunk for message " + std::to_string(header.messageId));
+  }
+  if (assembled + length > total) {
+    throw std::runtime_error("Chunk exceeds declared message length");
+  }
+  if (streaming) {
+    chunkBuffer.resize(length);
+    boost::asio::read(socket, boost::asio::buffer(chunkBuffer.data(), length));
+    consumer->append(chunkBuffer.data(), length);
+  } else {
+    boost::asio::read(socket, boost::asio::buffer(assembling.data() + assembled, length));
+  }
+  assembled += length;
+  if (prefix.marks & kChunkLast) {
+    if (assembled != total) {
+      throw std::runtime_error("Chunked message incomplete");
+    }
+    if (streaming) {
+      streaming = false;
+      consumer->end();
+      return false;
+    }
+    return true;
+  }
+  return false;
+}
+
+Buffer Reader::finish(Buffer &&message, uint8_t &flags) {
+  if (flags & kCompressedFlag) {
+    return compressor.inflate(message.data(), message.size(), flags);
+  }
+  return std::move(message);
+}
+} // namespace Frame
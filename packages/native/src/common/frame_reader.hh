@@ -0,0 +1,65 @@
+#ifndef __FRAME_READER_HH__
+#define __FRAME_READER_HH__
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <boost/asio.hpp>
+#include "buffer_pool.hh"
+#include "frame.hh"
+#include "frame_compression.hh"
+
+namespace Frame {
+  /**
+   * 接收端的帧读取
+   *
+   * 分块帧在此重组，重组期间穿插到达的普通帧直接返回；
+   * 压缩帧解压后返回，返回的flags不再带kChunkFlag/kCompressedFlag。
+   * 分块消息的总长是64位的，不受帧头32位长度的限制。
+   * 只在接收线程使用。
+   */
+  class Reader {
+  public:
+    /**
+     * 分块消息的增量消费者
+     *
+     * 首个分块到达时调用begin，返回true则接管该消息：之后每个分块读出后立即交给append，
+     * 最后一块之后调用end，read不再返回这条消息，也不为它分配整块缓冲区。
+     * 压缩消息需要整体解压，不会交给消费者。
+     */
+    class StreamConsumer {
+    public:
+      virtual ~StreamConsumer() = default;
+      virtual bool begin(int64_t messageId, uint8_t flags, uint64_t total) = 0;
+      virtual void append(const char *data, std::size_t length) = 0;
+      virtual void end() = 0;
+    };
+
+    Reader(boost::asio::generic::stream_protocol::socket &socket, Compressor &compressor);
+    // 返回的缓冲区来自BufferPool，用完即归还
+    Buffer read(int64_t *messageId, uint8_t *flags);
+    void setStreamConsumer(std::shared_ptr<StreamConsumer> consumer);
+    // 单条消息允许的最大长度，环境变量SKYLINE_MAX_MESSAGE_SIZE，0表示不限制
+    static uint64_t maxMessageSizeFromEnv();
+
+  private:
+    // 读入一个分块，消息完整且需要由read返回时返回true
+    bool readChunk(const Header &header);
+    Buffer finish(Buffer &&message, uint8_t &flags);
+
+    boost::asio::generic::stream_protocol::socket &socket;
+    Compressor &compressor;
+    uint64_t maxMessageSize;
+    std::shared_ptr<StreamConsumer> consumer;
+    // 正在接收的bulk消息
+    bool streaming = false;
+    Buffer assembling;
+    uint64_t total = 0;
+    uint64_t assembled = 0;
+    int64_t assemblingId = 0;
+    uint8_t assemblingFlags = 0;
+    // 流式消费时分块的读缓冲区，跨分块复用
+    std::string chunkBuffer;
+  };
+}
+
+#endif // __FRAME_READER_HH__
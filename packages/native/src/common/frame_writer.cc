@@ -0,0 +1,200 @@
+#include "frame_writer.hh"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace Frame {
+namespace {
+// 小于该长度的帧拷贝进连续缓冲区，减少iovec数量（asio单次最多提交64个）
+constexpr std::size_t kCoalesceLimit = 16 * 1024;
+} // namespace
+
+Writer::Writer(stream_socket &socket, ErrorHandler onError, bool chunking)
+    : socket(socket), onError(std::move(onError)), chunking(chunking) {
+  thread = std::thread([this]() { run(); });
+}
+
+Writer::~Writer() {
+  stop();
+  release(pending.exchange(nullptr, std::memory_order_acquire));
+  for (Node *node : queue) {
+    delete node;
+  }
+  queue.clear();
+}
+
+void Writer::stop() {
+  {
+    std::lock_guard<std::mutex> lock(idleMutex);
+    stopping.store(true, std::memory_order_release);
+  }
+  idleCv.notify_one();
+  if (thread.joinable() && thread.get_id() != std::this_thread::get_id()) {
+    thread.join();
+  }
+}
+
+nlohmann::json Writer::stats() const {
+  return laneStats.toJson();
+}
+
+void Writer::push(std::string &&message, int64_t messageId, uint8_t flags) {
+  if (stopping.load(std::memory_order_acquire)) {
+    throw std::runtime_error("Frame writer stopped");
+  }
+  // 分块消息的总长是64位的，只有整帧发送时受帧头32位长度限制
+  if (!chunking && message.size() > std::numeric_limits<uint32_t>::max()) {
+    throw std::length_error("Message too large for a single frame: " + std::to_string(message.size()));
+  }
+  auto node = new Node();
+  encodeHeader(node->header.data(), static_cast<uint32_t>(message.size()), messageId, flags);
+  node->lane = laneOf(message.size());
+  node->message = std::move(message);
+  node->messageId = messageId;
+  node->flags = flags;
+  node->enqueuedAt = std::chrono::steady_clock::now();
+  laneStats.begin(node->lane);
+
+  Node *head = pending.load(std::memory_order_relaxed);
+  do {
+    node->next = head;
+  } while (!pending.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+  if (head == nullptr) {
+    // 从空变为非空时发送线程可能在休眠
+    std::lock_guard<std::mutex> lock(idleMutex);
+    idleCv.notify_one();
+  }
+}
+
+void Writer::release(Node *list) {
+  while (list != nullptr) {
+    Node *next = list->next;
+    delete list;
+    list = next;
+  }
+}
+
+Writer::Node *Writer::takeAll(std::atomic<Node *> &stack) {
+  Node *list = stack.exchange(nullptr, std::memory_order_acquire);
+  // 栈是后进先出，反转回入队顺序
+  Node *ordered = nullptr;
+  while (list != nullptr) {
+    Node *next = list->next;
+    list->next = ordered;
+    ordered = list;
+    list = next;
+  }
+  return ordered;
+}
+
+bool Writer::hasPending() const {
+  return pending.load(std::memory_order_acquire) != nullptr;
+}
+
+void Writer::run() {
+  while (!stopping.load(std::memory_order_acquire)) {
+    for (Node *node = takeAll(pending); node != nullptr;) {
+      Node *next = node->next;
+      node->next = nullptr;
+      queue.push_back(node);
+      node = next;
+    }
+    if (queue.empty()) {
+      std::unique_lock<std::mutex> lock(idleMutex);
+      idleCv.wait(lock, [this]() {
+        return stopping.load(std::memory_order_acquire) || hasPending();
+      });
+      continue;
+    }
+    try {
+      flush();
+    } catch (const std::exception &e) {
+      stopping.store(true, std::memory_order_release);
+      onError(e);
+    }
+  }
+}
+
+void Writer::flush() {
+  // 本轮写出的帧：队首连续的整帧，以及其后第一条bulk消息的一个分块
+  std::size_t whole = 0;
+  std::size_t stagedSize = 0;
+  for (Node *node : queue) {
+    if (chunking && node->lane == Lane::Bulk) {
+      break;
+    }
+    if (node->message.size() <= kCoalesceLimit) {
+      stagedSize += kHeaderSize + node->message.size();
+    }
+    whole++;
+  }
+  // 先算出需要拷贝的总长度，一次预留，保证下面引用staging的指针不失效
+  staging.clear();
+  staging.reserve(stagedSize);
+
+  std::vector<boost::asio::const_buffer> buffers;
+  std::size_t stagedStart = 0;
+  auto closeStaged = [&]() {
+    if (staging.size() > stagedStart) {
+      buffers.emplace_back(staging.data() + stagedStart, staging.size() - stagedStart);
+      stagedStart = staging.size();
+    }
+  };
+  for (std::size_t i = 0; i < whole; i++) {
+    Node *node = queue[i];
+    if (node->message.size() <= kCoalesceLimit) {
+      staging.append(reinterpret_cast<const char *>(node->header.data()), node->header.size());
+      staging.append(node->message);
+    } else {
+      closeStaged();
+      buffers.emplace_back(node->header.data(), node->header.size());
+      buffers.emplace_back(node->message.data(), node->message.size());
+    }
+  }
+  closeStaged();
+
+  // 排在这些帧之后的bulk消息：每轮只写一个分块，写完之前后面的帧都等待
+  Node *bulk = whole < queue.size() ? queue[whole] : nullptr;
+  bool bulkDone = false;
+  if (bulk != nullptr) {
+    const std::size_t total = bulk->message.size();
+    const std::size_t length = std::min(kChunkSize, total - bulkOffset);
+    uint8_t marks = 0;
+    if (bulkOffset == 0) {
+      marks |= kChunkFirst;
+    }
+    if (bulkOffset + length == total) {
+      marks |= kChunkLast;
+      bulkDone = true;
+    }
+    encodeHeader(chunkHead.data(), static_cast<uint32_t>(kChunkPrefixSize + length), bulk->messageId,
+                 static_cast<uint8_t>(bulk->flags | kChunkFlag));
+    encodeChunkPrefix(chunkHead.data() + kHeaderSize, marks, total);
+    buffers.emplace_back(chunkHead.data(), chunkHead.size());
+    buffers.emplace_back(bulk->message.data() + bulkOffset, length);
+  }
+
+  boost::asio::write(socket, buffers);
+  const auto now = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < whole; i++) {
+    laneStats.end(queue.front()->lane, now - queue.front()->enqueuedAt);
+    delete queue.front();
+    queue.pop_front();
+  }
+  if (bulk != nullptr) {
+    bulkOffset += std::min(kChunkSize, bulk->message.size() - bulkOffset);
+    if (bulkDone) {
+      laneStats.end(bulk->lane, now - bulk->enqueuedAt);
+      queue.pop_front();
+      bulkOffset = 0;
+      delete bulk;
+    }
+  }
+  // 偶发的大批量不长期占用内存
+  if (staging.capacity() > 4 * 1024 * 1024) {
+    std::string().swap(staging);
+  }
+}
+} // namespace Frame
@@ -0,0 +1,85 @@
+#ifndef __FRAME_WRITER_HH__
+#define __FRAME_WRITER_HH__
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <boost/asio.hpp>
+#include <nlohmann/json.hpp>
+#include "frame.hh"
+#include "lane_stats.hh"
+
+namespace Frame {
+  /**
+   * 发送线程
+   *
+   * 调用方只把帧压入对应通道的无锁MPSC栈；发送线程一次取走全部待发帧，
+   * 按入队顺序拼成一次scatter-gather写入，连续的异步调用合并为一次系统调用。
+   * 同一个socket上只有这一个写入方。
+   *
+   * bulk通道的消息每次只写一个分块。帧严格按入队顺序写出：异步batch、同步调用、
+   * 回复之间都有先后依赖，之后入队的帧等在未写完的大消息后面，不会超车。
+   */
+  class Writer {
+  public:
+    using stream_socket = boost::asio::generic::stream_protocol::socket;
+    // 在发送线程中调用，之后该Writer不再发送
+    using ErrorHandler = std::function<void(const std::exception &)>;
+
+    // chunking为false时（对端不支持分块）bulk消息整条发送
+    Writer(stream_socket &socket, ErrorHandler onError, bool chunking = true);
+    ~Writer();
+    Writer(const Writer &) = delete;
+    Writer &operator=(const Writer &) = delete;
+
+    void push(std::string &&message, int64_t messageId, uint8_t flags);
+    // 停止发送线程，未发出的帧丢弃
+    void stop();
+    // 各通道从入队到写出的耗时
+    nlohmann::json stats() const;
+
+  private:
+    struct Node {
+      Node *next = nullptr;
+      std::array<uint8_t, kHeaderSize> header{};
+      std::string message;
+      int64_t messageId = 0;
+      uint8_t flags = 0;
+      Lane lane = Lane::Interactive;
+      std::chrono::steady_clock::time_point enqueuedAt;
+    };
+
+    void run();
+    bool hasPending() const;
+    // 取走全部待发帧，按入队顺序返回
+    static Node *takeAll(std::atomic<Node *> &stack);
+    // 按顺序写出队首的帧，遇到bulk消息时写出它的下一个分块后结束本轮
+    void flush();
+    static void release(Node *list);
+
+    stream_socket &socket;
+    ErrorHandler onError;
+    bool chunking;
+    std::atomic<Node *> pending{nullptr};
+    std::atomic<bool> stopping{false};
+    std::mutex idleMutex;
+    std::condition_variable idleCv;
+    // 以下只在发送线程访问
+    std::string staging;
+    std::deque<Node *> queue;
+    // 队首bulk消息已写出的长度
+    std::size_t bulkOffset = 0;
+    std::array<uint8_t, kHeaderSize + kChunkPrefixSize> chunkHead{};
+    LaneStats laneStats;
+    std::thread thread;
+  };
+}
+
+#endif // __FRAME_WRITER_HH__
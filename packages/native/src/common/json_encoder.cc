@@ -0,0 +1,220 @@
+#include "json_encoder.hh"
+#include <charconv>
+#include <cmath>
+#include "frame.hh"
+
+namespace Frame {
+namespace {
+void appendBigEndian(std::string &out, uint64_t value, std::size_t bytes) {
+  for (std::size_t i = bytes; i > 0; i--) {
+    out.push_back(static_cast<char>((value >> ((i - 1) * 8)) & 0xFF));
+  }
+}
+} // namespace
+
+void JsonEncoder::reset() {
+  out.clear();
+  attachments.clear();
+  attachmentSizes.clear();
+  started.clear();
+  afterKey = false;
+  escapedKeys = false;
+  out.reserve(lastSize);
+}
+
+void JsonEncoder::separate() {
+  if (afterKey) {
+    afterKey = false;
+    return;
+  }
+  if (!started.empty()) {
+    if (started.back()) {
+      out.push_back(',');
+    }
+    started.back() = true;
+  }
+}
+
+void JsonEncoder::beginObject() {
+  separate();
+  out.push_back('{');
+  started.push_back(false);
+}
+
+void JsonEncoder::endObject() {
+  out.push_back('}');
+  started.pop_back();
+}
+
+void JsonEncoder::beginArray() {
+  separate();
+  out.push_back('[');
+  started.push_back(false);
+}
+
+void JsonEncoder::endArray() {
+  out.push_back(']');
+  started.pop_back();
+}
+
+void JsonEncoder::key(std::string_view name) {
+  if (needsEscape(name)) {
+    escapedKeys = true;
+    rawKey(escapeKey(name));
+  } else {
+    rawKey(name);
+  }
+}
+
+void JsonEncoder::rawKey(std::string_view name) {
+  separate();
+  quote(name);
+  out.push_back(':');
+  afterKey = true;
+}
+
+void JsonEncoder::string(std::string_view value) {
+  separate();
+  quote(value);
+}
+
+void JsonEncoder::quote(std::string_view value) {
+  static const char *hex = "0123456789abcdef";
+  out.push_back('"');
+  for (char c : value) {
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\b':
+      out += "\\b";
+      break;
+    case '\f':
+      out += "\\f";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\r':
+      out += "\\r";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        out += "\\u00";
+        out.push_back(hex[(c >> 4) & 0x0F]);
+        out.push_back(hex[c & 0x0F]);
+      } else {
+        out.push_back(c);
+      }
+    }
+  }
+  out.push_back('"');
+}
+
+void JsonEncoder::number(double value) {
+  separate();
+  if (!std::isfinite(value)) {
+    out += "null";
+    return;
+  }
+  char buffer[32];
+  auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  std::string_view text(buffer, result.ptr - buffer);
+  out += text;
+  // 与dump()一致，整数值的double也带小数点
+  if (text.find_first_of(".e") == std::string_view::npos) {
+    out += ".0";
+  }
+}
+
+void JsonEncoder::integer(int64_t value) {
+  separate();
+  char buffer[24];
+  auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  out.append(buffer, result.ptr - buffer);
+}
+
+void JsonEncoder::boolean(bool value) {
+  separate();
+  out += value ? "true" : "false";
+}
+
+void JsonEncoder::null() {
+  separate();
+  out += "null";
+}
+
+void JsonEncoder::placeholder(std::size_t length) {
+  rawKey(kAttachmentKey);
+  integer(static_cast<int64_t>(attachmentSizes.size()));
+  attachmentSizes.push_back(length);
+}
+
+void JsonEncoder::binary(const uint8_t *data, std::size_t length, uint8_t subtype) {
+  beginObject();
+  placeholder(length);
+  key("subtype");
+  integer(subtype);
+  endObject();
+  attachments.append(reinterpret_cast<const char *>(data), length);
+}
+
+void JsonEncoder::json(const nlohmann::json &value) {
+  switch (value.type()) {
+  case nlohmann::json::value_t::object:
+    beginObject();
+    for (auto it = value.begin(); it != value.end(); ++it) {
+      key(it.key());
+      json(it.value());
+    }
+    endObject();
+    return;
+  case nlohmann::json::value_t::array:
+    beginArray();
+    for (const auto &item : value) {
+      json(item);
+    }
+    endArray();
+    return;
+  case nlohmann::json::value_t::binary: {
+    const auto &bytes = value.get_binary();
+    if (bytes.has_subtype()) {
+      binary(bytes.data(), bytes.size(), static_cast<uint8_t>(bytes.subtype()));
+    } else {
+      // 没有subtype的二进制值占位对象不带subtype
+      beginObject();
+      placeholder(bytes.size());
+      endObject();
+      attachments.append(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+    }
+    return;
+  }
+  default:
+    separate();
+    out += value.dump();
+  }
+}
+
+std::string JsonEncoder::finish(uint8_t &flags) {
+  flags = makeFlags(Codec::Json);
+  if (!attachmentSizes.empty() || escapedKeys) {
+    out += attachments;
+    for (auto size : attachmentSizes) {
+      appendBigEndian(out, size, sizeof(uint64_t));
+    }
+    appendBigEndian(out, attachmentSizes.size(), sizeof(uint32_t));
+    flags |= kAttachmentFlag;
+  }
+  lastSize = out.size();
+  std::string result;
+  result.swap(out);
+  reset();
+  return result;
+}
+} // namespace Frame
@@ -0,0 +1,59 @@
+#ifndef __JSON_ENCODER_HH__
+#define __JSON_ENCODER_HH__
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace Frame {
+  /**
+   * 直接写出JSON报文，不构建nlohmann::json
+   *
+   * 逗号由编码器维护，调用方只需按顺序写入键和值；输出与nlohmann::json::dump()等价。
+   * 二进制值写为附件占位对象，finish时按Frame::encode的格式追加附件。
+   * 以$开头的键总是转义；转义过键而没有附件时也带上空的附件表，接收端据此去掉转义。
+   * 缓冲区在finish之间复用，每次只按上一条报文的大小预留一次。
+   */
+  class JsonEncoder {
+  public:
+    void reset();
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+    void key(std::string_view name);
+
+    void string(std::string_view value);
+    void number(double value);
+    void integer(int64_t value);
+    void boolean(bool value);
+    void null();
+    void binary(const uint8_t *data, std::size_t length, uint8_t subtype);
+    // 已有的nlohmann::json值，其中的二进制值同样作为附件
+    void json(const nlohmann::json &value);
+
+    // 取出报文，flags为该帧的flags
+    std::string finish(uint8_t &flags);
+
+  private:
+    void separate();
+    void quote(std::string_view value);
+    // 不转义地写入键，用于占位对象
+    void rawKey(std::string_view name);
+    void placeholder(std::size_t length);
+
+    std::string out;
+    std::string attachments;
+    std::vector<uint64_t> attachmentSizes;
+    // 每层容器是否已写入过元素
+    std::vector<bool> started;
+    // 刚写完键，下一个值前不加逗号
+    bool afterKey = false;
+    bool escapedKeys = false;
+    std::size_t lastSize = 0;
+  };
+}
+
+#endif // __JSON_ENCODER_HH__
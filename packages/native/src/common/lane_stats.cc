@@ -0,0 +1,47 @@
+#include "lane_stats.hh"
+
+namespace Frame {
+LaneStats::Tracker::Tracker(LaneStats &stats, Lane lane)
+    : stats(stats), lane(lane), start(std::chrono::steady_clock::now()) {
+  stats.begin(lane);
+}
+
+LaneStats::Tracker::~Tracker() {
+  stats.end(lane, std::chrono::steady_clock::now() - start);
+}
+
+void LaneStats::begin(Lane lane) {
+  lanes[static_cast<std::size_t>(lane)].inflight.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LaneStats::end(Lane lane, std::chrono::steady_clock::duration elapsed) {
+  auto &counters = lanes[static_cast<std::size_t>(lane)];
+  const auto micros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+  counters.inflight.fetch_sub(1, std::memory_order_relaxed);
+  counters.completed.fetch_add(1, std::memory_order_relaxed);
+  counters.totalMicros.fetch_add(micros, std::memory_order_relaxed);
+  uint64_t max = counters.maxMicros.load(std::memory_order_relaxed);
+  while (micros > max && !counters.maxMicros.compare_exchange_weak(max, micros, std::memory_order_relaxed)) {
+  }
+}
+
+int64_t LaneStats::inflight(Lane lane) const {
+  return lanes[static_cast<std::size_t>(lane)].inflight.load(std::memory_order_relaxed);
+}
+
+nlohmann::json LaneStats::toJson() const {
+  nlohmann::json result = nlohmann::json::object();
+  for (std::size_t i = 0; i < kLaneCount; i++) {
+    const auto &counters = lanes[i];
+    const uint64_t completed = counters.completed.load(std::memory_order_relaxed);
+    const uint64_t total = counters.totalMicros.load(std::memory_order_relaxed);
+    result[laneName(static_cast<Lane>(i))] = nlohmann::json{
+        {"inflight", counters.inflight.load(std::memory_order_relaxed)},
+        {"completed", completed},
+        {"avgMicros", completed > 0 ? total / completed : 0},
+        {"maxMicros", counters.maxMicros.load(std::memory_order_relaxed)},
+    };
+  }
+  return result;
+}
+} // namespace Frame
@@ -0,0 +1,48 @@
+#ifndef __LANE_STATS_HH__
+#define __LANE_STATS_HH__
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include "frame.hh"
+
+namespace Frame {
+  /**
+   * 按通道统计的在途数量与耗时
+   *
+   * begin/end成对调用，可在任意线程使用
+   */
+  class LaneStats {
+  public:
+    // 作用域内计为在途，析构时记录耗时
+    class Tracker {
+    public:
+      Tracker(LaneStats &stats, Lane lane);
+      ~Tracker();
+      Tracker(const Tracker &) = delete;
+      Tracker &operator=(const Tracker &) = delete;
+
+    private:
+      LaneStats &stats;
+      Lane lane;
+      std::chrono::steady_clock::time_point start;
+    };
+
+    void begin(Lane lane);
+    void end(Lane lane, std::chrono::steady_clock::duration elapsed);
+    int64_t inflight(Lane lane) const;
+    nlohmann::json toJson() const;
+
+  private:
+    struct Counters {
+      std::atomic<int64_t> inflight{0};
+      std::atomic<uint64_t> completed{0};
+      std::atomic<uint64_t> totalMicros{0};
+      std::atomic<uint64_t> maxMicros{0};
+    };
+    std::array<Counters, kLaneCount> lanes;
+  };
+}
+
+#endif // __LANE_STATS_HH__
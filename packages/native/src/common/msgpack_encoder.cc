@@ -0,0 +1,210 @@
+#include "msgpack_encoder.hh"
+#include <cstring>
+#include <limits>
+#include "frame.hh"
+
+namespace Frame {
+namespace {
+void appendBigEndian(std::string &out, uint64_t value, std::size_t bytes) {
+  for (std::size_t i = bytes; i > 0; i--) {
+    out.push_back(static_cast<char>((value >> ((i - 1) * 8)) & 0xFF));
+  }
+}
+
+void appendMarker(std::string &out, uint8_t marker) {
+  out.push_back(static_cast<char>(marker));
+}
+} // namespace
+
+void MsgPackEncoder::reset() {
+  out.clear();
+  containers.clear();
+  afterKey = false;
+  out.reserve(lastSize);
+}
+
+void MsgPackEncoder::element() {
+  if (afterKey) {
+    afterKey = false;
+    return;
+  }
+  if (!containers.empty()) {
+    containers.back().count++;
+  }
+}
+
+void MsgPackEncoder::beginContainer(uint8_t marker) {
+  element();
+  appendMarker(out, marker);
+  containers.push_back({out.size(), 0});
+  out.append(4, '\0');
+}
+
+void MsgPackEncoder::endContainer() {
+  auto container = containers.back();
+  containers.pop_back();
+  for (std::size_t i = 0; i < 4; i++) {
+    out[container.offset + i] = static_cast<char>((container.count >> ((3 - i) * 8)) & 0xFF);
+  }
+}
+
+void MsgPackEncoder::beginObject() {
+  beginContainer(0xDF);
+}
+
+void MsgPackEncoder::endObject() {
+  endContainer();
+}
+
+void MsgPackEncoder::beginArray() {
+  beginContainer(0xDD);
+}
+
+void MsgPackEncoder::endArray() {
+  endContainer();
+}
+
+void MsgPackEncoder::key(std::string_view name) {
+  element();
+  raw(name);
+  afterKey = true;
+}
+
+void MsgPackEncoder::string(std::string_view value) {
+  element();
+  raw(value);
+}
+
+void MsgPackEncoder::raw(std::string_view value) {
+  const auto length = value.size();
+  if (length < 32) {
+    appendMarker(out, static_cast<uint8_t>(0xA0 | length));
+  } else if (length <= 0xFF) {
+    appendMarker(out, 0xD9);
+    appendBigEndian(out, length, 1);
+  } else if (length <= 0xFFFF) {
+    appendMarker(out, 0xDA);
+    appendBigEndian(out, length, 2);
+  } else {
+    appendMarker(out, 0xDB);
+    appendBigEndian(out, length, 4);
+  }
+  out += value;
+}
+
+void MsgPackEncoder::number(double value) {
+  element();
+  // 与to_msgpack()一致，能无损表示的写为float32
+  if (value >= std::numeric_limits<float>::lowest() && value <= std::numeric_limits<float>::max() &&
+      static_cast<double>(static_cast<float>(value)) == value) {
+    const auto single = static_cast<float>(value);
+    uint32_t bits = 0;
+    std::memcpy(&bits, &single, sizeof(bits));
+    appendMarker(out, 0xCA);
+    appendBigEndian(out, bits, 4);
+    return;
+  }
+  uint64_t bits = 0;
+  std::memcpy(&bits, &value, sizeof(bits));
+  appendMarker(out, 0xCB);
+  appendBigEndian(out, bits, 8);
+}
+
+void MsgPackEncoder::integer(int64_t value) {
+  element();
+  if (value >= 0) {
+    const auto unsignedValue = static_cast<uint64_t>(value);
+    if (unsignedValue < 0x80) {
+      appendMarker(out, static_cast<uint8_t>(unsignedValue));
+    } else if (unsignedValue <= 0xFF) {
+      appendMarker(out, 0xCC);
+      appendBigEndian(out, unsignedValue, 1);
+    } else if (unsignedValue <= 0xFFFF) {
+      appendMarker(out, 0xCD);
+      appendBigEndian(out, unsignedValue, 2);
+    } else if (unsignedValue <= 0xFFFFFFFF) {
+      appendMarker(out, 0xCE);
+      appendBigEndian(out, unsignedValue, 4);
+    } else {
+      appendMarker(out, 0xCF);
+      appendBigEndian(out, unsignedValue, 8);
+    }
+    return;
+  }
+  const auto bits = static_cast<uint64_t>(value);
+  if (value >= -32) {
+    appendMarker(out, static_cast<uint8_t>(bits & 0xFF));
+  } else if (value >= std::numeric_limits<int8_t>::min()) {
+    appendMarker(out, 0xD0);
+    appendBigEndian(out, bits, 1);
+  } else if (value >= std::numeric_limits<int16_t>::min()) {
+    appendMarker(out, 0xD1);
+    appendBigEndian(out, bits, 2);
+  } else if (value >= std::numeric_limits<int32_t>::min()) {
+    appendMarker(out, 0xD2);
+    appendBigEndian(out, bits, 4);
+  } else {
+    appendMarker(out, 0xD3);
+    appendBigEndian(out, bits, 8);
+  }
+}
+
+void MsgPackEncoder::boolean(bool value) {
+  element();
+  appendMarker(out, value ? 0xC3 : 0xC2);
+}
+
+void MsgPackEncoder::null() {
+  element();
+  appendMarker(out, 0xC0);
+}
+
+void MsgPackEncoder::binary(const uint8_t *data, std::size_t length, uint8_t subtype) {
+  element();
+  // 带subtype的二进制值写为ext，类型字节即subtype
+  switch (length) {
+  case 1:
+    appendMarker(out, 0xD4);
+    break;
+  case 2:
+    appendMarker(out, 0xD5);
+    break;
+  case 4:
+    appendMarker(out, 0xD6);
+    break;
+  case 8:
+    appendMarker(out, 0xD7);
+    break;
+  case 16:
+    appendMarker(out, 0xD8);
+    break;
+  default:
+    if (length <= 0xFF) {
+      appendMarker(out, 0xC7);
+      appendBigEndian(out, length, 1);
+    } else if (length <= 0xFFFF) {
+      appendMarker(out, 0xC8);
+      appendBigEndian(out, length, 2);
+    } else {
+      appendMarker(out, 0xC9);
+      appendBigEndian(out, length, 4);
+    }
+  }
+  appendMarker(out, subtype);
+  out.append(reinterpret_cast<const char *>(data), length);
+}
+
+void MsgPackEncoder::json(const nlohmann::json &value) {
+  element();
+  nlohmann::json::to_msgpack(value, nlohmann::detail::output_adapter<char>(out));
+}
+
+std::string MsgPackEncoder::finish(uint8_t &flags) {
+  flags = makeFlags(Codec::MsgPack);
+  lastSize = out.size();
+  std::string result;
+  result.swap(out);
+  reset();
+  return result;
+}
+} // namespace Frame
@@ -0,0 +1,54 @@
+#ifndef __MSGPACK_ENCODER_HH__
+#define __MSGPACK_ENCODER_HH__
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace Frame {
+  /**
+   * 直接写出MsgPack报文，不构建nlohmann::json
+   *
+   * 接口与JsonEncoder相同。对象和数组先写入map32/array32头，结束时回填元素个数；
+   * 解码结果与nlohmann::json::to_msgpack()等价。二进制值按原生ext/bin写出，没有附件。
+   */
+  class MsgPackEncoder {
+  public:
+    void reset();
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+    void key(std::string_view name);
+
+    void string(std::string_view value);
+    void number(double value);
+    void integer(int64_t value);
+    void boolean(bool value);
+    void null();
+    void binary(const uint8_t *data, std::size_t length, uint8_t subtype);
+    void json(const nlohmann::json &value);
+
+    std::string finish(uint8_t &flags);
+
+  private:
+    void element();
+    void beginContainer(uint8_t marker);
+    void endContainer();
+    void raw(std::string_view value);
+
+    struct Container {
+      std::size_t offset;
+      uint32_t count;
+    };
+    std::string out;
+    std::vector<Container> containers;
+    // 刚写完键，下一个值不计入元素个数
+    bool afterKey = false;
+    std::size_t lastSize = 0;
+  };
+}
+
+#endif // __MSGPACK_ENCODER_HH__
@@ -0,0 +1,389 @@
+#include "shm_channel.hh"
+#include "frame.hh"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+namespace Shm {
+namespace {
+constexpr uint32_t kMagic = 0x534B4C59; // "SKLY"
+constexpr uint32_t kLayoutVersion = 1;
+constexpr uint64_t kRingCapacity = 1ull << 20;
+constexpr std::size_t kDataOffset = 4096;
+constexpr std::size_t kRegionSize = kDataOffset + 2 * kRingCapacity;
+// 自旋窗口：覆盖一次小请求的往返，超过后休眠让出CPU
+constexpr auto kSpinDuration = std::chrono::microseconds(50);
+// 单核时对端要等本端让出CPU才能运行，自旋只会拖慢往返
+std::chrono::microseconds spinDuration() {
+  static const auto duration =
+      std::thread::hardware_concurrency() > 1 ? kSpinDuration : std::chrono::microseconds(0);
+  return duration;
+}
+constexpr long kFutexTimeoutNs = 50 * 1000 * 1000;
+
+// 共享内存头部，两端按同一布局访问（x86_64 Linux/Windows一致）
+struct Layout {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t capacity;
+  std::atomic<uint32_t> futexCapable[2];
+  RingHeader rings[2]; // [0] 客户端->服务端 [1] 服务端->客户端
+};
+static_assert(sizeof(Layout) <= kDataOffset, "Shared memory header too large");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared memory requires lock-free 64-bit atomics");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "Shared memory requires lock-free 32-bit atomics");
+
+Layout *layoutOf(uint8_t *base) {
+  return reinterpret_cast<Layout *>(base);
+}
+uint8_t *ringData(uint8_t *base, int index) {
+  return base + kDataOffset + index * kRingCapacity;
+}
+int writeIndex(Side side) {
+  return side == Side::Client ? 0 : 1;
+}
+int readIndex(Side side) {
+  return side == Side::Client ? 1 : 0;
+}
+
+void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+  _mm_pause();
+#else
+  std::this_thread::yield();
+#endif
+}
+
+#if defined(__linux__)
+// 跨进程使用，不能用FUTEX_PRIVATE_FLAG
+void futexWait(std::atomic<uint32_t> *word, uint32_t expected) {
+  timespec timeout{0, kFutexTimeoutNs};
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+}
+void futexWake(std::atomic<uint32_t> *word) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+#endif
+} // namespace
+
+Channel::Channel(Side side, uint8_t *base, std::size_t size, stream_socket &doorbell)
+    : side(side), base(base), size(size), doorbell(doorbell) {}
+
+std::unique_ptr<Channel> Channel::create(const std::string &name, stream_socket &doorbell) {
+#if defined(_WIN32)
+  throw std::runtime_error("Creating shared memory is not supported on this platform");
+#else
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    throw std::runtime_error("shm_open failed: " + std::string(std::strerror(errno)));
+  }
+  if (ftruncate(fd, kRegionSize) != 0) {
+    auto err = errno;
+    ::close(fd);
+    shm_unlink(name.c_str());
+    throw std::runtime_error("ftruncate failed: " + std::string(std::strerror(err)));
+  }
+  void *addr = mmap(nullptr, kRegionSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  auto err = errno;
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    throw std::runtime_error("mmap failed: " + std::string(std::strerror(err)));
+  }
+
+  auto layout = new (addr) Layout{};
+  layout->magic = kMagic;
+  layout->version = kLayoutVersion;
+  layout->capacity = kRingCapacity;
+#if defined(__linux__)
+  layout->futexCapable[writeIndex(Side::Client)].store(1);
+#endif
+  std::unique_ptr<Channel> channel(new Channel(Side::Client, static_cast<uint8_t *>(addr), kRegionSize, doorbell));
+  channel->name = name;
+  return channel;
+#endif
+}
+
+std::unique_ptr<Channel> Channel::open(const std::string &name, stream_socket &doorbell) {
+#if defined(_WIN32)
+  // wine把Linux根目录映射为Z:盘，POSIX共享内存位于/dev/shm
+  std::string path = "Z:\\dev\\shm\\" + (name.rfind('/', 0) == 0 ? name.substr(1) : name);
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    throw std::runtime_error("CreateFile failed for " + path + ": " + std::to_string(GetLastError()));
+  }
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    auto err = GetLastError();
+    CloseHandle(file);
+    throw std::runtime_error("CreateFileMapping failed: " + std::to_string(err));
+  }
+  void *addr = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, kRegionSize);
+  if (addr == nullptr) {
+    auto err = GetLastError();
+    CloseHandle(mapping);
+    CloseHandle(file);
+    throw std::runtime_error("MapViewOfFile failed: " + std::to_string(err));
+  }
+  std::unique_ptr<Channel> channel(new Channel(Side::Server, static_cast<uint8_t *>(addr), kRegionSize, doorbell));
+  channel->fileHandle = file;
+  channel->mappingHandle = mapping;
+#else
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  if (fd < 0) {
+    throw std::runtime_error("shm_open failed: " + std::string(std::strerror(errno)));
+  }
+  void *addr = mmap(nullptr, kRegionSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  auto err = errno;
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    throw std::runtime_error("mmap failed: " + std::string(std::strerror(err)));
+  }
+  std::unique_ptr<Channel> channel(new Channel(Side::Server, static_cast<uint8_t *>(addr), kRegionSize, doorbell));
+#endif
+
+  auto layout = layoutOf(channel->base);
+  if (layout->magic != kMagic || layout->version != kLayoutVersion || layout->capacity != kRingCapacity) {
+    throw std::runtime_error("Shared memory layout mismatch");
+  }
+#if defined(__linux__)
+  layout->futexCapable[writeIndex(Side::Server)].store(1);
+#endif
+  return channel;
+}
+
+std::string Channel::uniqueName() {
+  static std::atomic<uint32_t> counter{0};
+#if defined(_WIN32)
+  const auto pid = static_cast<unsigned long>(GetCurrentProcessId());
+#else
+  const auto pid = static_cast<unsigned long>(getpid());
+#endif
+  return "/skyline-" + std::to_string(pid) + "-" + std::to_string(counter.fetch_add(1));
+}
+
+Channel::~Channel() {
+#if defined(_WIN32)
+  UnmapViewOfFile(base);
+  if (mappingHandle != nullptr) {
+    CloseHandle(static_cast<HANDLE>(mappingHandle));
+  }
+  if (fileHandle != nullptr) {
+    CloseHandle(static_cast<HANDLE>(fileHandle));
+  }
+#else
+  munmap(base, size);
+#endif
+  unlink();
+}
+
+void Channel::unlink() {
+#if !defined(_WIN32)
+  if (!name.empty()) {
+    shm_unlink(name.c_str());
+    name.clear();
+  }
+#endif
+}
+
+bool Channel::useFutex() const {
+  auto layout = layoutOf(base);
+  return layout->futexCapable[0].load(std::memory_order_relaxed) != 0 &&
+         layout->futexCapable[1].load(std::memory_order_relaxed) != 0;
+}
+
+bool Channel::peerAlive() {
+#if defined(_WIN32)
+  WSAPOLLFD fd{};
+  fd.fd = doorbell.native_handle();
+  fd.events = POLLRDNORM;
+  if (WSAPoll(&fd, 1, 0) < 0) {
+    return false;
+  }
+  return (fd.revents & (POLLHUP | POLLERR | POLLNVAL)) == 0;
+#else
+  pollfd fd{};
+  fd.fd = doorbell.native_handle();
+#if defined(POLLRDHUP)
+  fd.events = POLLRDHUP;
+  constexpr short closedMask = POLLHUP | POLLERR | POLLNVAL | POLLRDHUP;
+#else
+  fd.events = POLLIN;
+  constexpr short closedMask = POLLHUP | POLLERR | POLLNVAL;
+#endif
+  if (::poll(&fd, 1, 0) < 0) {
+    return errno == EINTR;
+  }
+  return (fd.revents & closedMask) == 0;
+#endif
+}
+
+void Channel::wake(RingHeader &ring) {
+#if defined(__linux__)
+  if (useFutex()) {
+    ring.seq.fetch_add(1, std::memory_order_seq_cst);
+    if (ring.parked.load(std::memory_order_seq_cst) != 0) {
+      futexWake(&ring.seq);
+    }
+    return;
+  }
+#endif
+  // 只有清除标记的一方负责敲门，保证每次休眠对应一个字节
+  if (ring.parked.load(std::memory_order_seq_cst) != 0 && ring.parked.exchange(0, std::memory_order_seq_cst) == 1) {
+    uint8_t bell = 1;
+    boost::asio::write(doorbell, boost::asio::buffer(&bell, sizeof(bell)));
+  }
+}
+
+void Channel::waitForData(RingHeader &ring, uint64_t tail) {
+  auto deadline = std::chrono::steady_clock::now() + spinDuration();
+  uint32_t spins = 0;
+  while (ring.head.load(std::memory_order_acquire) == tail) {
+    if ((++spins & 63) != 0 || std::chrono::steady_clock::now() < deadline) {
+      cpuRelax();
+      continue;
+    }
+#if defined(__linux__)
+    if (useFutex()) {
+      const uint32_t seq = ring.seq.load(std::memory_order_acquire);
+      ring.parked.store(1, std::memory_order_seq_cst);
+      if (ring.head.load(std::memory_order_seq_cst) == tail) {
+        futexWait(&ring.seq, seq);
+      }
+      ring.parked.store(0, std::memory_order_relaxed);
+      if (ring.head.load(std::memory_order_acquire) == tail && !peerAlive()) {
+        throw std::runtime_error("Shared memory peer disconnected");
+      }
+      deadline = std::chrono::steady_clock::now() + spinDuration();
+      continue;
+    }
+#endif
+    ring.parked.store(1, std::memory_order_seq_cst);
+    if (ring.head.load(std::memory_order_seq_cst) != tail &&
+        ring.parked.exchange(0, std::memory_order_seq_cst) == 1) {
+      // 数据已到，撤销休眠
+      return;
+    }
+    // 等待生产者的唤醒字节，对端断开时read抛出异常
+    uint8_t bell = 0;
+    boost::asio::read(doorbell, boost::asio::buffer(&bell, sizeof(bell)));
+    deadline = std::chrono::steady_clock::now() + spinDuration();
+  }
+}
+
+void Channel::waitForSpace(RingHeader &ring, uint64_t head) {
+  // 环满只在大payload时出现，不值得引入第二套唤醒，退避轮询即可
+  uint32_t spins = 0;
+  while (head - ring.tail.load(std::memory_order_acquire) == kRingCapacity) {
+    if (spins++ < 1024) {
+      cpuRelax();
+      continue;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(20));
+    if ((spins & 1023) == 0 && !peerAlive()) {
+      throw std::runtime_error("Shared memory peer disconnected");
+    }
+  }
+}
+
+void Channel::write(RingHeader &ring, uint64_t &head, const uint8_t *data, std::size_t length) {
+  uint8_t *ringBase = ringData(base, writeIndex(side));
+  while (length > 0) {
+    const uint64_t used = head - ring.tail.load(std::memory_order_acquire);
+    if (used == kRingCapacity) {
+      // 先发布已写入的部分，让消费者腾出空间
+      ring.head.store(head, std::memory_order_seq_cst);
+      wake(ring);
+      waitForSpace(ring, head);
+      continue;
+    }
+    const std::size_t n = static_cast<std::size_t>(std::min<uint64_t>(length, kRingCapacity - used));
+    const std::size_t offset = static_cast<std::size_t>(head & (kRingCapacity - 1));
+    const std::size_t first = std::min<std::size_t>(n, kRingCapacity - offset);
+    std::memcpy(ringBase + offset, data, first);
+    std::memcpy(ringBase, data + first, n - first);
+    head += n;
+    data += n;
+    length -= n;
+  }
+}
+
+void Channel::read(uint8_t *data, std::size_t length) {
+  const int index = readIndex(side);
+  auto &ring = layoutOf(base)->rings[index];
+  const uint8_t *ringBase = ringData(base, index);
+  uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+  while (length > 0) {
+    const uint64_t available = ring.head.load(std::memory_order_acquire) - tail;
+    if (available == 0) {
+      waitForData(ring, tail);
+      continue;
+    }
+    const std::size_t n = static_cast<std::size_t>(std::min<uint64_t>(length, available));
+    const std::size_t offset = static_cast<std::size_t>(tail & (kRingCapacity - 1));
+    const std::size_t first = std::min<std::size_t>(n, kRingCapacity - offset);
+    std::memcpy(data, ringBase + offset, first);
+    std::memcpy(data + first, ringBase, n - first);
+    tail += n;
+    data += n;
+    length -= n;
+    ring.tail.store(tail, std::memory_order_release);
+  }
+}
+
+void Channel::sendMessage(const std::string &message, std::int64_t messageId, std::uint8_t flags) {
+  if (message.size() > std::numeric_limits<uint32_t>::max()) {
+    throw std::length_error("Message too large for shared memory frame: " + std::to_string(message.size()));
+  }
+  std::array<uint8_t, Frame::kHeaderSize> header{};
+  Frame::encodeHeader(header.data(), static_cast<uint32_t>(message.size()), messageId, flags);
+  auto &ring = layoutOf(base)->rings[writeIndex(side)];
+  uint64_t head = ring.head.load(std::memory_order_relaxed);
+  write(ring, head, header.data(), header.size());
+  write(ring, head, reinterpret_cast<const uint8_t *>(message.data()), message.size());
+  // 整帧写完后才发布，避免对端醒来只读到半帧
+  ring.head.store(head, std::memory_order_seq_cst);
+  wake(ring);
+}
+
+Frame::Buffer Channel::receiveMessage(std::int64_t *messageId, std::uint8_t *flags) {
+  std::array<uint8_t, Frame::kHeaderSize> header{};
+  read(header.data(), header.size());
+  const auto frame = Frame::decodeHeader(header.data());
+  if (messageId != nullptr) {
+    *messageId = frame.messageId;
+  }
+  if (flags != nullptr) {
+    *flags = frame.flags;
+  }
+  auto message = Frame::BufferPool::shared().acquire(frame.length);
+  read(reinterpret_cast<uint8_t *>(message.data()), message.size());
+  return message;
+}
+} // namespace Shm
@@ -0,0 +1,77 @@
+#ifndef __SHM_CHANNEL_HH__
+#define __SHM_CHANNEL_HH__
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <boost/asio.hpp>
+#include "buffer_pool.hh"
+
+/**
+ * 共享内存传输
+ *
+ * 同机时在socket握手后升级：客户端创建共享内存并把名称发给服务端，
+ * 之后的帧走一对SPSC字节环（格式与socket相同：12字节头 + payload），
+ * 原socket只用于唤醒休眠的一方和感知对端断开。
+ *
+ * 等待数据时先自旋，超时后休眠：双方都是Linux进程时用futex，
+ * 否则（服务端跑在wine下）通过socket写一个字节唤醒。
+ */
+namespace Shm {
+  using stream_socket = boost::asio::generic::stream_protocol::socket;
+
+  enum class Side : uint8_t {
+    Client = 0,
+    Server = 1,
+  };
+
+  // 单向字节环，位置单调递增，按容量取模定位
+  struct RingHeader {
+    alignas(64) std::atomic<uint64_t> head; // 生产者已发布的位置
+    alignas(64) std::atomic<uint64_t> tail; // 消费者已读取的位置
+    alignas(64) std::atomic<uint32_t> seq;  // futex字，每次发布+1
+    std::atomic<uint32_t> parked;           // 消费者已休眠/准备休眠
+  };
+
+  class Channel {
+  public:
+    // 客户端：创建共享内存
+    static std::unique_ptr<Channel> create(const std::string &name, stream_socket &doorbell);
+    // 服务端：按客户端发来的名称打开
+    static std::unique_ptr<Channel> open(const std::string &name, stream_socket &doorbell);
+    // 本进程内不重复的共享内存名称
+    static std::string uniqueName();
+    ~Channel();
+    Channel(const Channel &) = delete;
+    Channel &operator=(const Channel &) = delete;
+
+    // 双方映射完成后删除名称，进程退出后不留残余
+    void unlink();
+
+    // 单生产者：同一时刻只能有一个线程发送
+    void sendMessage(const std::string &message, std::int64_t messageId, std::uint8_t flags);
+    // 单消费者：只在接收线程调用
+    Frame::Buffer receiveMessage(std::int64_t *messageId, std::uint8_t *flags);
+
+  private:
+    Channel(Side side, uint8_t *base, std::size_t size, stream_socket &doorbell);
+    void write(RingHeader &ring, uint64_t &head, const uint8_t *data, std::size_t length);
+    void read(uint8_t *data, std::size_t length);
+    void waitForData(RingHeader &ring, uint64_t tail);
+    void waitForSpace(RingHeader &ring, uint64_t head);
+    void wake(RingHeader &ring);
+    bool useFutex() const;
+    bool peerAlive();
+
+    Side side;
+    uint8_t *base;
+    std::size_t size;
+    stream_socket &doorbell;
+    std::string name;
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+  };
+}
+
+#endif // __SHM_CHANNEL_HH__
@@ -29,6 +29,7 @@ static Napi::Object Init(Napi::Env env, Napi::Object exports) {
   exports.Set("sendMessageSync", Napi::Function::New(env, ServerAction::sendMessageSync));
   exports.Set("sendMessageSingle", Napi::Function::New(env, ServerAction::sendMessageSingle));
   exports.Set("blockUntilNextMessage", Napi::Function::New(env, ServerAction::blockUntilNextMessage));
+  exports.Set("stats", Napi::Function::New(env, ServerAction::stats));
   logger->info("return result");
   return exports;
 }
@@ -2,13 +2,19 @@
 #define __SERVER_HH__
 #include <cstdint>
 #include <napi.h>
+#include "../common/buffer_pool.hh"
+#include "../common/frame.hh"
 
 namespace SkylineServer {
     class Server {
     public:
         virtual void Init(const Napi::CallbackInfo &info) = 0;
-        virtual void sendMessage(std::string&& message, std::int64_t messageId = 0) = 0;
-        virtual std::string receiveMessage(std::int64_t *messageId = nullptr) = 0;
+        // 握手时客户端选定的编码
+        virtual Frame::Codec codec() = 0;
+        // 当前连接的传输统计
+        virtual nlohmann::json stats() = 0;
+        virtual void sendMessage(std::string&& message, std::int64_t messageId = 0, std::uint8_t flags = 0) = 0;
+        virtual Frame::Buffer receiveMessage(std::int64_t *messageId = nullptr, std::uint8_t *flags = nullptr) = 0;
     };
 }
 #endif // __SERVER_HH__
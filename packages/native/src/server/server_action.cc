@@ -1,5 +1,6 @@
 #include "server_action.hh"
 #include "server_socket.hh"
+#include "server_unix_socket.hh"
 #include <boost/asio.hpp>
 #include <condition_variable>
 #include <cstdint>
@@ -9,6 +10,9 @@
 #include <algorithm>
 #include "../common/logger.hh"
 #include "../common/convert.hh"
+#include "../common/buffer_pool.hh"
+#include "../common/frame.hh"
+#include "../common/lane_stats.hh"
 #include "server.hh"
 #include <nlohmann/json.hpp>
 
@@ -16,23 +20,48 @@ using Logger::logger;
 
 namespace ServerAction {
     struct BlockQueueItem {
-        std::string message;
+        Frame::Buffer message;
         int64_t messageId;
+        uint8_t flags;
     };
     static Napi::ThreadSafeFunction messageHandleTsfn;
     static std::shared_ptr<Napi::FunctionReference> messageHandleRef;
     static std::mutex socketRequestMutex;
     static std::condition_variable socketResponseCv;
-    static std::unordered_map<int64_t, std::shared_ptr<std::promise<std::string>>> socketRequest;
+    // 客户端对sendMessageSync的回复，原样交回JS线程解码
+    static std::unordered_map<int64_t, std::shared_ptr<std::promise<BlockQueueItem>>> socketRequest;
     static std::queue<BlockQueueItem> blockQueue;
     static std::mutex blockQueueMutex;
     static int64_t requestId = 2;
     static std::shared_ptr<SkylineServer::Server> server;
+    // 同步请求按通道统计在途数量与往返耗时
+    static Frame::LaneStats laneStats;
 
     static std::condition_variable cv_blockUntilNextMessage;
     static std::mutex cv_blockUntilNextMessage_mtx;
 
-    void processMessage(const std::string &message, int64_t messageId = 0) {
+    /**
+     * JSON帧直接交给JS做JSON.parse，二进制帧在此直接解码为普通JS对象
+     *
+     * batch帧解码为消息数组，一次回调交给JS逐条处理；带附件的帧中附件还原为ArrayBuffer/Buffer
+     */
+    static Napi::Value toJsMessage(Napi::Env env, const BlockQueueItem &item) {
+        auto codec = Frame::codecOf(item.flags);
+        if (codec == Frame::Codec::Json && !Frame::isBatch(item.flags) && !Frame::hasAttachments(item.flags)) {
+            return Napi::String::New(env, item.message.data(), item.message.size());
+        }
+        return Convert::decodeFrame2Value(env, item.message, item.flags);
+    }
+
+    // 日志中只输出纯JSON报文，二进制报文只记录长度
+    static std::string describeMessage(const Frame::Buffer &message, uint8_t flags) {
+        if (Frame::codecOf(flags) == Frame::Codec::Json && !Frame::hasAttachments(flags)) {
+            return std::string(message.view());
+        }
+        return "<" + std::string(Frame::codecName(Frame::codecOf(flags))) + " " + std::to_string(message.size()) + " bytes>";
+    }
+
+    void processMessage(Frame::Buffer &&message, int64_t messageId = 0, uint8_t flags = 0) {
         try {
             logger->debug("Received message with length: {}", message.size());
             
@@ -43,7 +72,7 @@ namespace ServerAction {
 
             int64_t id = messageId;
             if (id > 0) {
-              std::shared_ptr<std::promise<std::string>> promise;
+              std::shared_ptr<std::promise<BlockQueueItem>> promise;
               {
                 std::lock_guard<std::mutex> lock(socketRequestMutex);
                 if (auto target = socketRequest.find(id); target != socketRequest.end()) {
@@ -53,7 +82,7 @@ namespace ServerAction {
                 }
               }
               if (promise) {
-                promise->set_value(message);
+                promise->set_value(BlockQueueItem{std::move(message), messageId, flags});
                 socketResponseCv.notify_all();
                 return;
               }
@@ -61,8 +90,8 @@ namespace ServerAction {
             {
                 // 丢到阻塞队列中，可能在sendMessageSync处理，也可能在下面messageHandleTsfn中处理
                 std::lock_guard<std::mutex> lock(blockQueueMutex);
-                logger->debug("blocked, push to queue... {}", message);
-                blockQueue.push(BlockQueueItem{std::move(message), messageId});
+                logger->debug("blocked, push to queue, length: {}", message.size());
+                blockQueue.push(BlockQueueItem{std::move(message), messageId, flags});
             }
             socketResponseCv.notify_all();
 
@@ -81,9 +110,9 @@ namespace ServerAction {
                 }
 
                 try {
-                    logger->debug("Calling JS callback with message: {}", item.message);
+                    logger->debug("Calling JS callback with message length: {}", item.message.size());
                     jsCallback.Call({
-                        Napi::String::New(env, item.message),
+                        toJsMessage(env, item),
                         Napi::Number::New(env, item.messageId)
                     });
                     logger->debug("JS callback executed successfully");
@@ -97,15 +126,20 @@ namespace ServerAction {
             logger->debug("Invoking ThreadSafeFunction callback, id: {}", id);
             messageHandleTsfn.NonBlockingCall(callback);
         } catch (const std::exception &e) {
-            logger->error("Error processing message: {}\noriginal message: {}", e.what(), message);
+            logger->error("Error processing message: {}\noriginal message: {}", e.what(), describeMessage(message, flags));
         } catch (...) {
-            logger->error("Unknown error occurred while processing message\noriginal message: {}", message);
+            logger->error("Unknown error occurred while processing message\noriginal message: {}", describeMessage(message, flags));
         }
     }
 
     int startInner(const Napi::CallbackInfo &info) {
         try {
-            server = std::make_shared<SkylineServer::ServerSocket>();
+            auto host = info[0].As<Napi::String>().Utf8Value();
+            if (host.rfind("unix:", 0) == 0) {
+                server = std::make_shared<SkylineServer::ServerUnixSocket>();
+            } else {
+                server = std::make_shared<SkylineServer::ServerSocket>();
+            }
             server->Init(info);
 
             std::thread([&]() {
@@ -113,11 +147,12 @@ namespace ServerAction {
                     try {
                         // Handle client in a separate thread
                         int64_t messageId = 0;
-                        auto msg = server->receiveMessage(&messageId);
+                        uint8_t flags = 0;
+                        auto msg = server->receiveMessage(&messageId, &flags);
                         if (msg.empty()) {
                             continue;
                         }
-                        processMessage(msg, messageId);
+                        processMessage(std::move(msg), messageId, flags);
                         cv_blockUntilNextMessage.notify_all();
                     } catch (const std::exception &e) {
                         logger->error("Error in message processing thread: {}", e.what());
@@ -197,21 +232,22 @@ namespace ServerAction {
       auto env = info.Env();
       auto message = info[0].As<Napi::String>().Utf8Value();
       logger->debug("sendMessageSync payload length: {}", message.size());
-      if (requestId >= INT64_MAX - 1) {
+      if (requestId >= Frame::kMaxMessageId - 1) {
         requestId = 2;
       }
       auto id = requestId;
       requestId += 2;
 
       // 先存储，再发送
-      auto promiseObj = std::make_shared<std::promise<std::string>>();
-      std::future<std::string> futureObj = promiseObj->get_future();
+      auto promiseObj = std::make_shared<std::promise<BlockQueueItem>>();
+      std::future<BlockQueueItem> futureObj = promiseObj->get_future();
       {
         std::lock_guard<std::mutex> lock(socketRequestMutex);
         socketRequest.emplace(id, promiseObj);
       }
       logger->info("Sending to client: {}", id);
-      server->sendMessage(std::move(message), id);
+      Frame::LaneStats::Tracker tracker(laneStats, Frame::laneOf(message.size()));
+      server->sendMessage(std::move(message), id, Frame::makeFlags(Frame::Codec::Json));
       // 3秒超时
       auto start = std::chrono::high_resolution_clock::now();
       auto handleOneBlockedMessage = [&]() {
@@ -227,7 +263,7 @@ namespace ServerAction {
         try {
           logger->debug("start to handle blocked message, length: {}", msg.message.size());
           messageHandleRef->Value().Call({
-            Napi::String::New(env, msg.message),
+            toJsMessage(env, msg),
             Napi::Number::New(env, msg.messageId)
           });
         } catch (const std::exception &e) {
@@ -272,21 +308,28 @@ namespace ServerAction {
           break;
         }
       }
-      std::string result = futureObj.get();
-      auto resp = nlohmann::json::parse(result);
-      auto v = Convert::convertJson2Value(env, resp["result"]);
-      return v;
+      auto resp = futureObj.get();
+      try {
+        auto decoded = Convert::decodeFrame2Value(env, resp.message, resp.flags);
+        auto result = decoded.IsObject() ? decoded.As<Napi::Object>().Get("result") : env.Undefined();
+        // 回调没有返回值时客户端发送null
+        return result.IsNull() ? env.Undefined() : result;
+      } catch (const std::exception &e) {
+        throw Napi::Error::New(env, e.what());
+      }
     }
     /**
      * 给客户端发送消息
+     *
+     * 字符串按JSON帧发送；对象按握手协商的编码序列化后发送
      */
     Napi::Value sendMessageSingle(const Napi::CallbackInfo &info) {
         if (info.Length() < 1) {
             throw Napi::TypeError::New(info.Env(), "sendMessageSingle: Wrong number of arguments");
         }
         
-        if (!info[0].IsString()) {
-            throw Napi::TypeError::New(info.Env(), "First argument must be a string");
+        if (!info[0].IsString() && !info[0].IsObject()) {
+            throw Napi::TypeError::New(info.Env(), "First argument must be a string or an object");
         }
         int64_t messageId = 0;
         if (info.Length() > 1) {
@@ -295,7 +338,15 @@ namespace ServerAction {
             }
             messageId = info[1].As<Napi::Number>().Int64Value();
         }
-        server->sendMessage(std::move(info[0].As<Napi::String>().Utf8Value()), messageId);
+        if (info[0].IsString()) {
+            server->sendMessage(std::move(info[0].As<Napi::String>().Utf8Value()), messageId, Frame::makeFlags(Frame::Codec::Json));
+        } else {
+            auto env = info.Env();
+            auto codec = server->codec();
+            uint8_t flags = 0;
+            auto payload = Frame::encode(Convert::convertValue2Json(env, info[0]), codec, flags);
+            server->sendMessage(std::move(payload), messageId, flags);
+        }
         return info.Env().Undefined();
     }
     /**
@@ -306,4 +357,17 @@ namespace ServerAction {
         cv_blockUntilNextMessage.wait(lock);
         return info.Env().Undefined();
     }
+    /**
+     * 当前连接的传输统计
+     */
+    Napi::Value stats(const Napi::CallbackInfo &info) {
+        auto env = info.Env();
+        if (!server) {
+            return env.Null();
+        }
+        auto stats = server->stats();
+        stats["roundTrip"] = laneStats.toJson();
+        stats["bufferPool"] = Frame::BufferPool::shared().stats();
+        return Convert::convertJson2Value(env, stats);
+    }
 }
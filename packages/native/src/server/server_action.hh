@@ -11,6 +11,7 @@ namespace ServerAction {
     Napi::Value sendMessageSync(const Napi::CallbackInfo &info);
     Napi::Value sendMessageSingle(const Napi::CallbackInfo &info);
     Napi::Value blockUntilNextMessage(const Napi::CallbackInfo &info);
+    Napi::Value stats(const Napi::CallbackInfo &info);
 }
 
 #endif // __SOCKET_SERVER_HH__
@@ -12,28 +12,19 @@ using Logger::logger;
 using boost::asio::ip::tcp;
 
 namespace SkylineServer {
-namespace {
-uint64_t hostToNetwork64(uint64_t value) {
-    static const uint16_t one = 1;
-    if (*reinterpret_cast<const uint8_t *>(&one) == 0) {
-        return value;
-    }
-    const uint32_t high = htonl(static_cast<uint32_t>(value >> 32));
-    const uint32_t low = htonl(static_cast<uint32_t>(value & 0xFFFFFFFFULL));
-    return (static_cast<uint64_t>(low) << 32) | high;
-}
-
-uint64_t networkToHost64(uint64_t value) { return hostToNetwork64(value); }
-} // namespace
 
+std::unique_ptr<ServerSocket::socket_acceptor> ServerSocket::listen(const std::string &host, int port) {
+    tcp::acceptor tcp_acceptor(io_context, tcp::endpoint(tcp::v4(), port));
+    logger->info("Socket server listening on *:{}", port);
+    return std::make_unique<socket_acceptor>(std::move(tcp_acceptor));
+}
 void ServerSocket::Init(const Napi::CallbackInfo &info) {
     try {
-        auto env = info.Env();
+        auto host = info[0].As<Napi::String>().Utf8Value();
         auto port = info[1].As<Napi::Number>().Int32Value();
         
-        acceptor = std::make_unique<tcp::acceptor>(io_context, tcp::endpoint(tcp::v4(), port));
-        socket = std::make_unique<tcp::socket>(io_context);
-        logger->info("Socket server listening on *:{}", port);
+        acceptor = listen(host, port);
+        socket = std::make_unique<stream_socket>(io_context);
 
         // Run the IO context in a separate thread
         std::thread([this]() {
@@ -49,6 +40,7 @@ void ServerSocket::Init(const Napi::CallbackInfo &info) {
 }
 ServerSocket::~ServerSocket() {
     try {
+        channel.reset();
         if (socket && socket->is_open()) {
             socket->close();
         }
@@ -61,20 +53,69 @@ ServerSocket::~ServerSocket() {
         logger->error("Error stopping socket server: {}", e.what());
     }
 }
-void ServerSocket::sendMessage(std::string&& message, std::int64_t messageId) {
+Frame::Codec ServerSocket::codec() {
+    return negotiated_codec;
+}
+nlohmann::json ServerSocket::stats() {
+    std::lock_guard<std::mutex> lock(transport_mutex);
+    return nlohmann::json{
+        {"transport", channel ? "sharedMemory" : "socket"},
+        {"codec", Frame::codecName(negotiated_codec)},
+        {"compression", compressor->stats()},
+        {"sendQueue", writer ? writer->stats() : nlohmann::json()},
+    };
+}
+void ServerSocket::handshake() {
+    // 握手数据：magic + 本端支持的编码
+    std::array<uint32_t, 2> hello = {
+        htonl(Frame::kHandshakeMagic),
+        htonl(Frame::localCapabilities()),
+    };
+    boost::asio::write(*socket, boost::asio::buffer(hello.data(), sizeof(uint32_t) * hello.size()));
+    // 客户端回复选定的编码
+    uint32_t selection = 0;
+    boost::asio::read(*socket, boost::asio::buffer(&selection, sizeof(selection)));
+    selection = ntohl(selection);
+    negotiated_codec = Frame::decodeSelection(selection);
+    {
+        auto connectionCompressor = std::make_unique<Frame::Compressor>(Frame::Compressor::thresholdFromEnv());
+        connectionCompressor->setEnabled(Frame::hasCompression(selection));
+        chunking = Frame::hasChunking(selection);
+        std::lock_guard<std::mutex> lock(transport_mutex);
+        compressor = std::move(connectionCompressor);
+    }
+    logger->info("Negotiated wire codec: {}", Frame::codecName(negotiated_codec));
+    if (Frame::hasSharedMemory(selection)) {
+        acceptSharedMemory();
+    }
+}
+void ServerSocket::acceptSharedMemory() {
+    uint32_t length = 0;
+    boost::asio::read(*socket, boost::asio::buffer(&length, sizeof(length)));
+    std::string name(ntohl(length), '\0');
+    boost::asio::read(*socket, boost::asio::buffer(name.data(), name.size()));
+    uint32_t ack = htonl(1);
     try {
-        if (socket && socket->is_open()) {
-            std::array<uint8_t, sizeof(uint32_t) + sizeof(uint64_t)> header{};
-            const uint32_t message_length = htonl(static_cast<uint32_t>(message.size()));
-            const uint64_t message_id = hostToNetwork64(static_cast<uint64_t>(messageId));
-            std::memcpy(header.data(), &message_length, sizeof(message_length));
-            std::memcpy(header.data() + sizeof(uint32_t), &message_id, sizeof(message_id));
-            std::array<boost::asio::const_buffer, 2> buffers = {
-                boost::asio::buffer(header.data(), header.size()),
-                boost::asio::buffer(message)
-            };
-            boost::asio::write(*socket, buffers);
-            logger->debug("Sent message with length {}", message.size());
+        auto opened = Shm::Channel::open(name, *socket);
+        std::lock_guard<std::mutex> lock(transport_mutex);
+        channel = std::move(opened);
+        logger->info("Upgraded transport to shared memory: {}", name);
+    } catch (const std::exception &e) {
+        logger->warn("Failed to open shared memory {}, falling back to socket: {}", name, e.what());
+        ack = htonl(0);
+    }
+    boost::asio::write(*socket, boost::asio::buffer(&ack, sizeof(ack)));
+}
+void ServerSocket::sendMessage(std::string&& message, std::int64_t messageId, std::uint8_t flags) {
+    try {
+        std::lock_guard<std::mutex> lock(transport_mutex);
+        if (channel) {
+            channel->sendMessage(message, messageId, flags);
+        } else if (writer) {
+            logger->debug("Queued message with length {}", message.size());
+            // 共享内存不受带宽限制，只在socket上压缩
+            compressor->deflate(message, flags);
+            writer->push(std::move(message), messageId, flags);
         } else {
             logger->error("Socket is not open. Cannot send message.");
         }
@@ -82,50 +123,52 @@ void ServerSocket::sendMessage(std::string&& message, std::int64_t messageId) {
         logger->error("Error sending message: {}", e.what());
     }
 }
-std::string ServerSocket::receiveMessage(std::int64_t *messageId) {
+Frame::Buffer ServerSocket::receiveMessage(std::int64_t *messageId, std::uint8_t *flags) {
     try {
-        if (socket && socket->is_open()) {
-            std::array<uint8_t, sizeof(uint32_t) + sizeof(uint64_t)> header{};
-            boost::asio::read(*socket, boost::asio::buffer(header.data(), header.size()));
-
-            uint32_t message_length_net = 0;
-            std::memcpy(&message_length_net, header.data(), sizeof(message_length_net));
-            const uint32_t message_length = ntohl(message_length_net);
-
-            uint64_t raw_message_id = 0;
-            std::memcpy(&raw_message_id, header.data() + sizeof(uint32_t), sizeof(raw_message_id));
-            if (messageId != nullptr) {
-                *messageId = static_cast<int64_t>(networkToHost64(raw_message_id));
-            }
-
-            // Then read the actual message
-            std::string message(message_length, '\0');
-            boost::asio::read(*socket, boost::asio::buffer(message.data(), message_length));
-            return message;
+        if (channel) {
+            return channel->receiveMessage(messageId, flags);
+        } else if (reader && socket && socket->is_open()) {
+            return reader->read(messageId, flags);
         } else {
             // 关闭上一次连接残留的 socket，重新创建后再 accept
             if (socket) {
                 boost::system::error_code ec;
                 socket->close(ec);
             }
-            socket = std::make_unique<tcp::socket>(io_context);
+            socket = std::make_unique<stream_socket>(io_context);
             logger->info("Waiting for client connection...");
             acceptor->accept(*socket);
-            boost::asio::ip::tcp::no_delay option(true);
-            socket->set_option(option);
+            if (socket->local_endpoint().protocol().protocol() == IPPROTO_TCP) {
+                boost::asio::ip::tcp::no_delay option(true);
+                socket->set_option(option);
+            }
             logger->info("Client connected");
-            // 握手数据
-            uint32_t message_length = htonl(static_cast<uint32_t>(114514));
-            boost::asio::write(*socket, boost::asio::buffer(&message_length, sizeof(message_length)));
-            return "";
+            handshake();
+            if (!channel) {
+                std::lock_guard<std::mutex> lock(transport_mutex);
+                writer = std::make_unique<Frame::Writer>(*socket, [](const std::exception &e) {
+                    logger->error("Error sending message: {}", e.what());
+                }, chunking);
+                reader = std::make_unique<Frame::Reader>(*socket, *compressor);
+            }
+            return Frame::Buffer();
         }
     } catch (const std::exception &e) {
         logger->error("Error receiving message: {}", e.what());
         // 关闭 socket，使下次调用进入 accept 分支等待新连接
+        std::unique_ptr<Frame::Writer> staleWriter;
+        {
+            std::lock_guard<std::mutex> lock(transport_mutex);
+            channel.reset();
+            staleWriter = std::move(writer);
+            reader.reset();
+        }
         if (socket) {
             boost::system::error_code ec;
             socket->close(ec);
         }
+        // socket关闭后阻塞中的写入会立即失败，再等待发送线程退出
+        staleWriter.reset();
         std::this_thread::sleep_for(std::chrono::seconds(1));
         throw; // 重新抛出异常，让调用者处理
     }
@@ -1,25 +1,59 @@
 #ifndef __SERVER_SOCKET_HH__
 #define __SERVER_SOCKET_HH__
 #include "server.hh"
+#include "../common/frame_compression.hh"
+#include "../common/frame_reader.hh"
+#include "../common/frame_writer.hh"
+#include "../common/shm_channel.hh"
 #ifdef _WIN32
 #include <winsock2.h>
 #include <windows.h>
 #pragma comment(lib, "ws2_32.lib")
 #endif
 #include <boost/asio.hpp>
+#include <memory>
+#include <mutex>
 
 using boost::asio::ip::tcp;
 namespace SkylineServer {
+    /**
+     * 基于流式socket的服务端传输层，默认TCP
+     *
+     * 子类只需替换listen()即可换用其他流式协议
+     * 客户端在握手中请求时，帧改走共享内存（见Shm::Channel）
+     * socket上的发送由Frame::Writer的发送线程完成，调用方只负责入队
+     */
     class ServerSocket : public Server {
     public:
+        using stream_socket = boost::asio::generic::stream_protocol::socket;
+        using socket_acceptor = boost::asio::basic_socket_acceptor<boost::asio::generic::stream_protocol>;
+
         void Init(const Napi::CallbackInfo &info);
-        ~ServerSocket();
-        void sendMessage(std::string&& message, std::int64_t messageId = 0);
-        std::string receiveMessage(std::int64_t *messageId = nullptr);
-    private:
+        virtual ~ServerSocket();
+        Frame::Codec codec();
+        nlohmann::json stats();
+        void sendMessage(std::string&& message, std::int64_t messageId = 0, std::uint8_t flags = 0);
+        Frame::Buffer receiveMessage(std::int64_t *messageId = nullptr, std::uint8_t *flags = nullptr);
+    protected:
+        // 开始监听
+        virtual std::unique_ptr<socket_acceptor> listen(const std::string &host, int port);
         boost::asio::io_context io_context;
-        std::unique_ptr<tcp::acceptor> acceptor;
-        std::unique_ptr<tcp::socket> socket;
+    private:
+        void handshake();
+        // 客户端请求共享内存时打开并回复结果
+        void acceptSharedMemory();
+        std::unique_ptr<socket_acceptor> acceptor;
+        std::unique_ptr<stream_socket> socket;
+        std::unique_ptr<Shm::Channel> channel;
+        std::unique_ptr<Frame::Writer> writer;
+        // 每个连接重新创建，统计按连接计算
+        std::unique_ptr<Frame::Compressor> compressor = std::make_unique<Frame::Compressor>(Frame::Compressor::thresholdFromEnv());
+        // 只在接收线程使用
+        std::unique_ptr<Frame::Reader> reader;
+        bool chunking = false;
+        // 保护channel/writer/compressor在连接切换时的替换
+        std::mutex transport_mutex;
+        Frame::Codec negotiated_codec = Frame::Codec::Json;
     };
 }
 #endif // __SERVER_SOCKET_HH__
@@ -0,0 +1,23 @@
+#include "server_unix_socket.hh"
+#include <boost/asio.hpp>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include "../common/logger.hh"
+
+using Logger::logger;
+
+namespace SkylineServer {
+    std::unique_ptr<ServerSocket::socket_acceptor> ServerUnixSocket::listen(const std::string &host, int port) {
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+        std::string path = host.rfind("unix:", 0) == 0 ? host.substr(5) : host;
+        // 上次异常退出残留的socket文件会导致bind失败
+        std::remove(path.c_str());
+        boost::asio::local::stream_protocol::acceptor unix_acceptor(io_context, boost::asio::local::stream_protocol::endpoint(path));
+        logger->info("Socket server listening on unix:{}", path);
+        return std::make_unique<socket_acceptor>(std::move(unix_acceptor));
+#else
+        throw std::runtime_error("Unix domain sockets are not supported on this platform");
+#endif
+    }
+}
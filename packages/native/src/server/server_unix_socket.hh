@@ -0,0 +1,17 @@
+#ifndef __SERVER_UNIX_SOCKET_HH__
+#define __SERVER_UNIX_SOCKET_HH__
+#include "server_socket.hh"
+
+namespace SkylineServer {
+    /**
+     * Unix domain socket传输层
+     *
+     * host格式为 unix:<socket文件路径>，port忽略。
+     * wine下Windows 10+的AF_UNIX同样可用。
+     */
+    class ServerUnixSocket : public ServerSocket {
+    protected:
+        std::unique_ptr<socket_acceptor> listen(const std::string &host, int port);
+    };
+}
+#endif // __SERVER_UNIX_SOCKET_HH__
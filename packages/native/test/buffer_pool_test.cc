@@ -0,0 +1,81 @@
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include "buffer_pool.hh"
+#include "frame.hh"
+
+namespace Frame {
+namespace {
+uint64_t statOf(const char *name) {
+  return BufferPool::shared().stats()[name].get<uint64_t>();
+}
+} // namespace
+
+TEST(BufferPool, ReservesPadding) {
+  for (std::size_t size : {std::size_t(0), std::size_t(1), std::size_t(255), std::size_t(4096), std::size_t(100000)}) {
+    auto buffer = BufferPool::shared().acquire(size);
+    EXPECT_EQ(buffer.size(), size);
+    EXPECT_GE(buffer.capacity(), size + kReceivePadding);
+  }
+}
+
+TEST(BufferPool, CopiesShareMemory) {
+  auto buffer = BufferPool::shared().copyOf("hello");
+  Buffer copy = buffer;
+  EXPECT_EQ(copy.data(), buffer.data());
+  EXPECT_EQ(copy.view(), "hello");
+  buffer.reset();
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(copy.view(), "hello");
+
+  Buffer moved = std::move(copy);
+  EXPECT_EQ(copy.data(), nullptr);
+  EXPECT_EQ(moved.view(), "hello");
+}
+
+TEST(BufferPool, ReusesReleasedBlocks) {
+  const char *first = nullptr;
+  {
+    auto buffer = BufferPool::shared().acquire(1000);
+    first = buffer.data();
+  }
+  const auto reused = statOf("reused");
+  auto buffer = BufferPool::shared().acquire(1000);
+  EXPECT_EQ(buffer.data(), first);
+  EXPECT_EQ(statOf("reused"), reused + 1);
+}
+
+TEST(BufferPool, OversizedBuffersAreUnpooled) {
+  const auto unpooled = statOf("unpooled");
+  auto buffer = BufferPool::shared().acquire(8u << 20);
+  EXPECT_EQ(buffer.size(), 8u << 20);
+  EXPECT_EQ(statOf("unpooled"), unpooled + 1);
+}
+
+TEST(BufferPool, Truncate) {
+  auto buffer = BufferPool::shared().copyOf("abcdef");
+  buffer.truncate(3);
+  EXPECT_EQ(buffer.view(), "abc");
+  // 不能超过原长度
+  buffer.truncate(10);
+  EXPECT_EQ(buffer.view(), "abc");
+}
+
+TEST(BufferPool, ReleaseFromOtherThread) {
+  std::vector<Buffer> buffers;
+  for (int i = 0; i < 64; i++) {
+    buffers.push_back(BufferPool::shared().copyOf(std::to_string(i)));
+  }
+  // 接收线程取出、JS线程归还
+  std::thread consumer([moved = std::move(buffers)]() mutable {
+    for (std::size_t i = 0; i < moved.size(); i++) {
+      EXPECT_EQ(moved[i].view(), std::to_string(i));
+    }
+    moved.clear();
+  });
+  consumer.join();
+  EXPECT_GT(statOf("cachedBlocks"), 0u);
+}
+} // namespace Frame
@@ -0,0 +1,86 @@
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <gtest/gtest.h>
+#include "frame.hh"
+#include "frame_compression.hh"
+
+namespace Frame {
+namespace {
+std::string repetitive(std::size_t size) {
+  std::string text;
+  while (text.size() < size) {
+    text += "{\"type\":\"dynamicProperty\",\"instanceId\":" + std::to_string(text.size() % 97) + "},";
+  }
+  text.resize(size);
+  return text;
+}
+} // namespace
+
+TEST(Compressor, RoundTrip) {
+  Compressor compressor(1024);
+  compressor.setEnabled(true);
+  const auto original = repetitive(64 * 1024);
+  auto message = original;
+  uint8_t flags = makeFlags(Codec::Json);
+  compressor.deflate(message, flags);
+  ASSERT_TRUE(flags & kCompressedFlag);
+  EXPECT_LT(message.size(), original.size());
+
+  auto inflated = compressor.inflate(message.data(), message.size(), flags);
+  EXPECT_FALSE(flags & kCompressedFlag);
+  EXPECT_EQ(codecOf(flags), Codec::Json);
+  EXPECT_EQ(inflated.view(), original);
+
+  const auto stats = compressor.stats();
+  EXPECT_EQ(stats["sent"]["frames"], 1);
+  EXPECT_EQ(stats["received"]["rawBytes"], original.size());
+}
+
+TEST(Compressor, SkipsSmallOrDisabled) {
+  Compressor compressor(1024);
+  auto message = repetitive(4096);
+  uint8_t flags = 0;
+  // 握手前未启用
+  compressor.deflate(message, flags);
+  EXPECT_EQ(flags, 0);
+
+  compressor.setEnabled(true);
+  auto small = repetitive(512);
+  compressor.deflate(small, flags);
+  EXPECT_EQ(flags, 0);
+  EXPECT_EQ(small.size(), 512u);
+
+  Compressor off(0);
+  off.setEnabled(true);
+  EXPECT_FALSE(off.enabled());
+}
+
+TEST(Compressor, SkipsIncompressible) {
+  Compressor compressor(16);
+  compressor.setEnabled(true);
+  std::string message;
+  uint32_t state = 2463534242u;
+  for (int i = 0; i < 4096; i++) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    message.push_back(static_cast<char>(state));
+  }
+  const auto original = message;
+  uint8_t flags = 0;
+  compressor.deflate(message, flags);
+  EXPECT_EQ(flags, 0);
+  EXPECT_EQ(message, original);
+}
+
+TEST(Compressor, RejectsCorruptFrames) {
+  Compressor compressor;
+  uint8_t flags = kCompressedFlag;
+  EXPECT_THROW(compressor.inflate("\x00\x01", 2, flags), std::runtime_error);
+  // 长度前缀超过上限
+  EXPECT_THROW(compressor.inflate("\x7f\xff\xff\xff\x00", 5, flags), std::runtime_error);
+  // 声明的原始长度与解压结果不符
+  EXPECT_THROW(compressor.inflate("\x00\x00\x00\x10\xff\xff", 6, flags), std::runtime_error);
+}
+} // namespace Frame
@@ -0,0 +1,154 @@
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include "frame.hh"
+#include "json_encoder.hh"
+#include "msgpack_encoder.hh"
+
+namespace Frame {
+namespace {
+nlohmann::json binaryOf(std::size_t size, uint8_t subtype) {
+  nlohmann::json::binary_t::container_type content(size);
+  for (std::size_t i = 0; i < size; i++) {
+    content[i] = static_cast<uint8_t>(i * 13);
+  }
+  return nlohmann::json::binary(std::move(content), subtype);
+}
+
+// 按Convert::encodeValue的方式逐个调用编码器，不经过encoder.json
+template <typename Encoder>
+void write(Encoder &encoder, const nlohmann::json &value) {
+  switch (value.type()) {
+  case nlohmann::json::value_t::object:
+    encoder.beginObject();
+    for (auto it = value.begin(); it != value.end(); ++it) {
+      encoder.key(it.key());
+      write(encoder, it.value());
+    }
+    encoder.endObject();
+    return;
+  case nlohmann::json::value_t::array:
+    encoder.beginArray();
+    for (const auto &item : value) {
+      write(encoder, item);
+    }
+    encoder.endArray();
+    return;
+  case nlohmann::json::value_t::string:
+    encoder.string(value.get_ref<const std::string &>());
+    return;
+  case nlohmann::json::value_t::boolean:
+    encoder.boolean(value.get<bool>());
+    return;
+  case nlohmann::json::value_t::number_integer:
+  case nlohmann::json::value_t::number_unsigned:
+    encoder.integer(value.get<int64_t>());
+    return;
+  case nlohmann::json::value_t::number_float:
+    encoder.number(value.get<double>());
+    return;
+  case nlohmann::json::value_t::binary: {
+    const auto &bytes = value.get_binary();
+    encoder.binary(bytes.data(), bytes.size(), static_cast<uint8_t>(bytes.subtype()));
+    return;
+  }
+  default:
+    encoder.null();
+  }
+}
+
+// 直接编码与先构建nlohmann::json再编码，解码结果应相同
+template <typename Encoder>
+void expectSameAsDom(const nlohmann::json &value, Codec codec) {
+  Encoder encoder;
+  write(encoder, value);
+  uint8_t directFlags = 0;
+  const auto direct = encoder.finish(directFlags);
+  uint8_t referenceFlags = 0;
+  const auto reference = encode(value, codec, referenceFlags);
+  EXPECT_EQ(directFlags, referenceFlags);
+  EXPECT_EQ(decode(direct, codec, directFlags), decode(reference, codec, referenceFlags));
+}
+
+nlohmann::json sample() {
+  nlohmann::json integers = nlohmann::json::array();
+  for (int64_t value : {int64_t(0), int64_t(127), int64_t(128), int64_t(255), int64_t(256), int64_t(65535),
+                        int64_t(65536), int64_t(0xFFFFFFFF), int64_t(0x100000000), std::numeric_limits<int64_t>::max(),
+                        int64_t(-1), int64_t(-32), int64_t(-33), int64_t(-128), int64_t(-129), int64_t(-32768),
+                        int64_t(-32769), int64_t(-2147483648LL), int64_t(-2147483649LL),
+                        std::numeric_limits<int64_t>::min()}) {
+    integers.push_back(value);
+  }
+  nlohmann::json binaries = nlohmann::json::array();
+  for (std::size_t size : {0, 1, 2, 3, 4, 8, 16, 17, 255, 256, 65535, 65536}) {
+    binaries.push_back(binaryOf(size, static_cast<uint8_t>(size % 0x20)));
+  }
+  return nlohmann::json{
+      {"data", {{"instanceId", 42}, {"params", {1.0, 2.5, 1e300, -0.1, "three", nullptr, true, false}}}},
+      {"integers", integers},
+      {"binaries", binaries},
+      {"strings", {"", std::string(31, 'a'), std::string(32, 'b'), std::string(256, 'c'), std::string(70000, 'd'),
+                   "引号\"和\\反斜杠\n\t\x01"}},
+      {"nested", {{"empty", nlohmann::json::object()}, {"list", nlohmann::json::array()}, {"deep", {{{"a", {{"b", 1}}}}}}}},
+  };
+}
+} // namespace
+
+TEST(Encoder, JsonMatchesDom) {
+  expectSameAsDom<JsonEncoder>(sample(), Codec::Json);
+}
+
+TEST(Encoder, MsgPackMatchesDom) {
+  expectSameAsDom<MsgPackEncoder>(sample(), Codec::MsgPack);
+}
+
+TEST(Encoder, MsgPackLargeContainers) {
+  nlohmann::json list = nlohmann::json::array();
+  nlohmann::json object = nlohmann::json::object();
+  for (int i = 0; i < 70000; i++) {
+    list.push_back(i);
+    object[std::to_string(i)] = i % 3 == 0;
+  }
+  expectSameAsDom<MsgPackEncoder>(nlohmann::json{{"list", list}, {"object", object}}, Codec::MsgPack);
+}
+
+TEST(Encoder, MsgPackEmbeddedJson) {
+  // 已构建好的值（如函数转换出的回调引用）与直接写入的值混合
+  MsgPackEncoder encoder;
+  encoder.beginObject();
+  encoder.key("callback");
+  encoder.json(nlohmann::json{{"callbackId", 3}, {"type", "function"}});
+  encoder.key("list");
+  encoder.beginArray();
+  encoder.json(nlohmann::json::array({1, 2}));
+  encoder.integer(3);
+  encoder.endArray();
+  encoder.endObject();
+  uint8_t flags = 0;
+  const auto payload = encoder.finish(flags);
+  EXPECT_EQ(codecOf(flags), Codec::MsgPack);
+  const nlohmann::json expected{{"callback", {{"callbackId", 3}, {"type", "function"}}}, {"list", {{1, 2}, 3}}};
+  EXPECT_EQ(decode(payload, Codec::MsgPack, flags), expected);
+}
+
+TEST(Encoder, ReusedAfterFinishAndReset) {
+  MsgPackEncoder encoder;
+  encoder.beginArray();
+  encoder.string("discarded");
+  encoder.reset();
+  encoder.beginArray();
+  encoder.integer(1);
+  encoder.endArray();
+  uint8_t flags = 0;
+  auto first = encoder.finish(flags);
+  EXPECT_EQ(decode(first, Codec::MsgPack, flags), nlohmann::json::array({1}));
+  encoder.beginObject();
+  encoder.key("k");
+  encoder.null();
+  encoder.endObject();
+  auto second = encoder.finish(flags);
+  EXPECT_EQ(decode(second, Codec::MsgPack, flags), nlohmann::json({{"k", nullptr}}));
+}
+} // namespace Frame
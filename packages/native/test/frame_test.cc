@@ -0,0 +1,265 @@
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include "buffer_pool.hh"
+#include "frame.hh"
+#include "frame_message.hh"
+#include "json_encoder.hh"
+
+namespace Frame {
+namespace {
+nlohmann::json binaryOf(const std::string &bytes, int subtype = -1) {
+  nlohmann::json::binary_t::container_type content(bytes.begin(), bytes.end());
+  return subtype < 0 ? nlohmann::json::binary(std::move(content))
+                     : nlohmann::json::binary(std::move(content), static_cast<std::uint8_t>(subtype));
+}
+} // namespace
+
+TEST(FrameHeader, RoundTrip) {
+  std::array<uint8_t, kHeaderSize> bytes{};
+  const uint8_t flags = makeFlags(Codec::Cbor) | kBatchFlag | kAttachmentFlag;
+  encodeHeader(bytes.data(), 0xDEADBEEF, kMaxMessageId, flags);
+  const auto header = decodeHeader(bytes.data());
+  EXPECT_EQ(header.length, 0xDEADBEEFu);
+  EXPECT_EQ(header.messageId, kMaxMessageId);
+  EXPECT_EQ(header.flags, flags);
+}
+
+TEST(FrameHeader, BigEndianLayout) {
+  std::array<uint8_t, kHeaderSize> bytes{};
+  encodeHeader(bytes.data(), 0x01020304, 0x05, kChunkFlag);
+  const std::array<uint8_t, kHeaderSize> expected{0x01, 0x02, 0x03, 0x04, kChunkFlag, 0, 0, 0, 0, 0, 0, 0x05};
+  EXPECT_EQ(bytes, expected);
+}
+
+TEST(FrameHeader, MessageIdDoesNotLeakIntoFlags) {
+  std::array<uint8_t, kHeaderSize> bytes{};
+  // 超过56位的id被截断，不能改写flags
+  encodeHeader(bytes.data(), 0, -1, 0);
+  const auto header = decodeHeader(bytes.data());
+  EXPECT_EQ(header.flags, 0);
+  EXPECT_EQ(header.messageId, kMaxMessageId);
+}
+
+TEST(FrameFlags, Packing) {
+  for (auto codec : {Codec::Json, Codec::MsgPack, Codec::Cbor}) {
+    const uint8_t flags = makeFlags(codec);
+    EXPECT_EQ(codecOf(flags), codec);
+    EXPECT_EQ(versionOf(flags), kProtocolVersion);
+    EXPECT_FALSE(isBatch(flags));
+    EXPECT_FALSE(hasAttachments(flags));
+    // 其他位不影响编码和版本
+    const uint8_t all = flags | kBatchFlag | kCompressedFlag | kChunkFlag | kAttachmentFlag;
+    EXPECT_EQ(codecOf(all), codec);
+    EXPECT_EQ(versionOf(all), kProtocolVersion);
+    EXPECT_TRUE(isBatch(all));
+    EXPECT_TRUE(hasAttachments(all));
+  }
+}
+
+TEST(FrameFlags, ChunkPrefixRoundTrip) {
+  std::array<uint8_t, kChunkPrefixSize> bytes{};
+  encodeChunkPrefix(bytes.data(), kChunkFirst | kChunkLast, 0x0102030405060708ull);
+  const auto prefix = decodeChunkPrefix(bytes.data());
+  EXPECT_EQ(prefix.marks, kChunkFirst | kChunkLast);
+  EXPECT_EQ(prefix.total, 0x0102030405060708ull);
+}
+
+TEST(FrameFlags, Lane) {
+  EXPECT_EQ(laneOf(0), Lane::Interactive);
+  EXPECT_EQ(laneOf(kChunkSize), Lane::Interactive);
+  EXPECT_EQ(laneOf(kChunkSize + 1), Lane::Bulk);
+}
+
+TEST(Handshake, LocalCapabilities) {
+  const uint32_t capabilities = localCapabilities();
+  EXPECT_EQ(capabilities >> 16, kProtocolVersion);
+  EXPECT_TRUE(hasSharedMemory(capabilities));
+  EXPECT_TRUE(hasCompression(capabilities));
+  EXPECT_TRUE(hasChunking(capabilities));
+  for (auto codec : {Codec::Json, Codec::MsgPack, Codec::Cbor}) {
+    EXPECT_EQ(negotiateCodec(capabilities, codec), codec);
+  }
+}
+
+TEST(Handshake, NegotiateFallsBackToJson) {
+  // 对端只支持JSON
+  const uint32_t jsonOnly = (static_cast<uint32_t>(kProtocolVersion) << 16) | 1u;
+  EXPECT_EQ(negotiateCodec(jsonOnly, Codec::MsgPack), Codec::Json);
+  // 旧版本对端
+  EXPECT_EQ(negotiateCodec(0x07, Codec::Cbor), Codec::Json);
+  EXPECT_FALSE(hasSharedMemory(kSharedMemoryBit));
+}
+
+TEST(Handshake, SelectionRoundTrip) {
+  for (auto codec : {Codec::Json, Codec::MsgPack, Codec::Cbor}) {
+    const uint32_t selection = encodeSelection(codec, kCompressionBit | kChunkingBit);
+    EXPECT_EQ(decodeSelection(selection), codec);
+    EXPECT_TRUE(hasCompression(selection));
+    EXPECT_TRUE(hasChunking(selection));
+    EXPECT_FALSE(hasSharedMemory(selection));
+  }
+  // 未知的特性位不会写入
+  EXPECT_EQ(encodeSelection(Codec::Json, 1u << 15) & (1u << 15), 0u);
+}
+
+TEST(Handshake, BadSelectionWord) {
+  const uint32_t version = static_cast<uint32_t>(kProtocolVersion) << 16;
+  EXPECT_EQ(decodeSelection(version | 3), Codec::Json);
+  // 超出移位宽度的编码值
+  EXPECT_EQ(decodeSelection(version | 32), Codec::Json);
+  EXPECT_EQ(decodeSelection(version | 40), Codec::Json);
+  EXPECT_EQ(decodeSelection(version | 0xFF), Codec::Json);
+  EXPECT_EQ(decodeSelection((2u << 16) | static_cast<uint32_t>(Codec::Cbor)), Codec::Json);
+}
+
+TEST(Handshake, CodecNames) {
+  for (auto codec : {Codec::Json, Codec::MsgPack, Codec::Cbor}) {
+    EXPECT_EQ(parseCodec(codecName(codec)), codec);
+  }
+  EXPECT_THROW(parseCodec("bson"), std::invalid_argument);
+}
+
+TEST(Codec, RoundTrip) {
+  const nlohmann::json data{
+      {"type", "dynamic"},
+      {"data", {{"instanceId", 42}, {"args", {1, 2.5, "three", nullptr, true}}}},
+  };
+  for (auto codec : {Codec::Json, Codec::MsgPack, Codec::Cbor}) {
+    uint8_t flags = 0;
+    const auto payload = encode(data, codec, flags);
+    EXPECT_EQ(codecOf(flags), codec);
+    EXPECT_FALSE(hasAttachments(flags));
+    EXPECT_EQ(decode(payload, codec, flags), data);
+  }
+}
+
+TEST(Codec, InstanceReferenceRoundTrip) {
+  // 服务端回复的实例引用，两个键都要保留，客户端据此创建代理
+  const nlohmann::json reply{
+      {"result", {{"instanceId", 7}, {"instanceType", "WebRequestEvent"}}},
+      {"list", {{{"instanceId", 8}, {"instanceType", "function"}}}},
+  };
+  for (auto codec : {Codec::Json, Codec::MsgPack, Codec::Cbor}) {
+    uint8_t flags = 0;
+    const auto decoded = decode(encode(reply, codec, flags), codec, flags);
+    EXPECT_EQ(decoded, reply);
+    EXPECT_EQ(decoded["result"]["instanceType"], "WebRequestEvent");
+  }
+}
+
+TEST(Attachments, RoundTrip) {
+  const nlohmann::json data{
+      {"first", binaryOf(std::string("\x00\x01\x02", 3), 5)},
+      {"list", {binaryOf("plain"), 7, binaryOf("")}},
+  };
+  uint8_t flags = 0;
+  const auto payload = encode(data, Codec::Json, flags);
+  ASSERT_TRUE(hasAttachments(flags));
+  EXPECT_EQ(decode(payload, Codec::Json, flags), data);
+
+  auto split = splitAttachments(payload);
+  ASSERT_EQ(split.blobs.size(), 3u);
+  EXPECT_EQ(split.blobs[0], std::string("\x00\x01\x02", 3));
+  EXPECT_EQ(split.blobs[1], "plain");
+  EXPECT_EQ(split.blobs[2], "");
+  EXPECT_TRUE(nlohmann::json::accept(split.body));
+}
+
+TEST(Attachments, NativeBinaryForMsgPackAndCbor) {
+  const nlohmann::json data{{"blob", binaryOf("bytes", 1)}, {"plain", binaryOf("raw")}};
+  for (auto codec : {Codec::MsgPack, Codec::Cbor}) {
+    uint8_t flags = 0;
+    const auto payload = encode(data, codec, flags);
+    EXPECT_FALSE(hasAttachments(flags));
+    EXPECT_EQ(decode(payload, codec, flags), data);
+  }
+}
+
+TEST(Attachments, UserKeysLikePlaceholder) {
+  // 用户对象恰好带有占位对象的键，不能被当作附件
+  const nlohmann::json data{
+      {"user", {{kAttachmentKey, 0}, {"subtype", 1}}},
+      {"$$double", {{"$", 1}}},
+      {"blob", binaryOf("bytes", 1)},
+  };
+  uint8_t flags = 0;
+  const auto payload = encode(data, Codec::Json, flags);
+  ASSERT_TRUE(hasAttachments(flags));
+  EXPECT_EQ(decode(payload, Codec::Json, flags), data);
+
+  JsonEncoder encoder;
+  encoder.json(data);
+  const auto direct = encoder.finish(flags);
+  ASSERT_TRUE(hasAttachments(flags));
+  EXPECT_EQ(decode(direct, Codec::Json, flags), data);
+
+  Message message(BufferPool::shared().copyOf(direct), Codec::Json, flags);
+  EXPECT_EQ(message.json(), data);
+  EXPECT_EQ(message.json("/user"), data["user"]);
+}
+
+TEST(Attachments, EscapedKeysWithoutBlobs) {
+  // 没有二进制值时转义过的键仍要能还原
+  const nlohmann::json data{{"user", {{kAttachmentKey, 3}}}};
+  JsonEncoder encoder;
+  encoder.json(data);
+  uint8_t flags = 0;
+  const auto payload = encoder.finish(flags);
+  ASSERT_TRUE(hasAttachments(flags));
+  EXPECT_TRUE(splitAttachments(payload).blobs.empty());
+  EXPECT_EQ(decode(payload, Codec::Json, flags), data);
+
+  // 不带附件的帧不做转义，也不识别占位对象
+  const auto plain = encode(data, Codec::Json, flags);
+  EXPECT_FALSE(hasAttachments(flags));
+  EXPECT_EQ(decode(plain, Codec::Json, flags), data);
+  Message message(BufferPool::shared().copyOf(plain), Codec::Json, flags);
+  EXPECT_FALSE(message.hasAttachments());
+  EXPECT_EQ(message.json(), data);
+}
+
+TEST(Attachments, KeyEscaping) {
+  EXPECT_FALSE(needsEscape(""));
+  EXPECT_FALSE(needsEscape("key$"));
+  EXPECT_TRUE(needsEscape("$"));
+  EXPECT_EQ(escapeKey("$a"), "$$a");
+  EXPECT_EQ(unescapeKey("$$a"), "$a");
+  EXPECT_EQ(unescapeKey(kAttachmentKey), kAttachmentKey);
+  EXPECT_EQ(unescapeKey("$"), "$");
+}
+
+TEST(Attachments, TruncatedTrailer) {
+  EXPECT_THROW(splitAttachments(std::string("\x00\x00", 2)), std::runtime_error);
+  // 声明了2个附件但没有长度表
+  EXPECT_THROW(splitAttachments(std::string("{}\x00\x00\x00\x02", 6)), std::runtime_error);
+}
+
+TEST(Attachments, SizeExceedsPayload) {
+  std::string payload = "{}";
+  payload += std::string("\x00\x00\x00\x00\x00\x00\x00\x10", 8);
+  payload += std::string("\x00\x00\x00\x01", 4);
+  EXPECT_THROW(splitAttachments(payload), std::runtime_error);
+}
+
+TEST(Attachments, SizesOverflow) {
+  // 长度之和回绕后小于payload
+  std::string payload = "{}xx";
+  payload += std::string("\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF", 8);
+  payload += std::string("\x00\x00\x00\x00\x00\x00\x00\x03", 8);
+  payload += std::string("\x00\x00\x00\x02", 4);
+  EXPECT_THROW(splitAttachments(payload), std::runtime_error);
+}
+
+TEST(Attachments, IndexOutOfRange) {
+  uint8_t flags = 0;
+  auto payload = encode(nlohmann::json{{"blob", binaryOf("x")}}, Codec::Json, flags);
+  auto split = splitAttachments(payload);
+  auto body = nlohmann::json::parse(split.body);
+  body["blob"][kAttachmentKey] = 3;
+  EXPECT_THROW(restoreAttachments(body, split.blobs), std::runtime_error);
+}
+} // namespace Frame
@@ -0,0 +1,107 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <boost/asio.hpp>
+#include <gtest/gtest.h>
+#include "frame.hh"
+#include "shm_channel.hh"
+
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS) && !defined(_WIN32)
+namespace Shm {
+namespace {
+// 同一进程内的两端，socket只用作门铃
+struct ChannelPair {
+  boost::asio::io_context io;
+  std::unique_ptr<stream_socket> clientBell;
+  std::unique_ptr<stream_socket> serverBell;
+  std::unique_ptr<Channel> client;
+  std::unique_ptr<Channel> server;
+
+  ChannelPair() {
+    boost::asio::local::stream_protocol::socket a(io), b(io);
+    boost::asio::local::connect_pair(a, b);
+    clientBell = std::make_unique<stream_socket>(std::move(a));
+    serverBell = std::make_unique<stream_socket>(std::move(b));
+    const auto name = Channel::uniqueName();
+    client = Channel::create(name, *clientBell);
+    server = Channel::open(name, *serverBell);
+    client->unlink();
+  }
+};
+
+std::string patterned(std::size_t size) {
+  std::string text(size, '\0');
+  for (std::size_t i = 0; i < size; i++) {
+    text[i] = static_cast<char>(i * 31 + i / 251);
+  }
+  return text;
+}
+} // namespace
+
+TEST(ShmChannel, RoundTripBothDirections) {
+  ChannelPair pair;
+  pair.client->sendMessage("ping", 1, Frame::makeFlags(Frame::Codec::MsgPack));
+  int64_t messageId = 0;
+  uint8_t flags = 0;
+  auto received = pair.server->receiveMessage(&messageId, &flags);
+  EXPECT_EQ(received.view(), "ping");
+  EXPECT_EQ(messageId, 1);
+  EXPECT_EQ(Frame::codecOf(flags), Frame::Codec::MsgPack);
+
+  pair.server->sendMessage("pong", 1, Frame::makeFlags(Frame::Codec::Json));
+  received = pair.client->receiveMessage(&messageId, &flags);
+  EXPECT_EQ(received.view(), "pong");
+}
+
+TEST(ShmChannel, WrapsAroundRing) {
+  ChannelPair pair;
+  // 每条约300KB，多次写入后位置越过环尾
+  const auto message = patterned(300 * 1024);
+  for (int i = 0; i < 10; i++) {
+    pair.client->sendMessage(message, i, 0);
+    int64_t messageId = -1;
+    auto received = pair.server->receiveMessage(&messageId, nullptr);
+    ASSERT_EQ(messageId, i);
+    ASSERT_EQ(received.view(), message);
+  }
+}
+
+TEST(ShmChannel, FullRingBlocksProducer) {
+  ChannelPair pair;
+  // 超过环容量，生产者要等消费者腾出空间
+  const auto message = patterned(3 * 1024 * 1024);
+  std::atomic<bool> sent{false};
+  std::thread producer([&]() {
+    pair.client->sendMessage(message, 42, 0);
+    sent.store(true);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(sent.load());
+  int64_t messageId = 0;
+  auto received = pair.server->receiveMessage(&messageId, nullptr);
+  producer.join();
+  EXPECT_TRUE(sent.load());
+  EXPECT_EQ(messageId, 42);
+  EXPECT_EQ(received.view(), message);
+}
+
+TEST(ShmChannel, FullRingPeerDisconnected) {
+  ChannelPair pair;
+  pair.serverBell->close();
+  const auto message = patterned(2 * 1024 * 1024);
+  EXPECT_THROW(pair.client->sendMessage(message, 1, 0), std::runtime_error);
+}
+
+TEST(ShmChannel, OpenMissing) {
+  boost::asio::io_context io;
+  boost::asio::local::stream_protocol::socket a(io), b(io);
+  boost::asio::local::connect_pair(a, b);
+  stream_socket bell(std::move(a));
+  EXPECT_THROW(Channel::open(Channel::uniqueName(), bell), std::runtime_error);
+}
+} // namespace Shm
+#endif
@@ -0,0 +1,239 @@
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/asio.hpp>
+#include <gtest/gtest.h>
+#include "frame.hh"
+#include "frame_compression.hh"
+#include "frame_reader.hh"
+#include "frame_writer.hh"
+
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+namespace Frame {
+namespace {
+using stream_socket = boost::asio::generic::stream_protocol::socket;
+
+// 一对相连的socket：writer端和reader端
+struct SocketPair {
+  boost::asio::io_context io;
+  std::unique_ptr<stream_socket> writer;
+  std::unique_ptr<stream_socket> reader;
+
+  SocketPair() {
+    boost::asio::local::stream_protocol::socket a(io), b(io);
+    boost::asio::local::connect_pair(a, b);
+    writer = std::make_unique<stream_socket>(std::move(a));
+    reader = std::make_unique<stream_socket>(std::move(b));
+  }
+
+  void writeFrame(const std::string &payload, int64_t messageId, uint8_t flags) {
+    std::array<uint8_t, kHeaderSize> header{};
+    encodeHeader(header.data(), static_cast<uint32_t>(payload.size()), messageId, flags);
+    boost::asio::write(*writer, boost::asio::buffer(header));
+    boost::asio::write(*writer, boost::asio::buffer(payload));
+  }
+
+  void writeChunk(const std::string &data, int64_t messageId, uint8_t marks, uint64_t total) {
+    std::array<uint8_t, kChunkPrefixSize> prefix{};
+    encodeChunkPrefix(prefix.data(), marks, total);
+    writeFrame(std::string(reinterpret_cast<const char *>(prefix.data()), prefix.size()) + data, messageId,
+               makeFlags(Codec::Json) | kChunkFlag);
+  }
+};
+
+std::string patterned(std::size_t size) {
+  std::string text(size, '\0');
+  for (std::size_t i = 0; i < size; i++) {
+    text[i] = static_cast<char>('a' + (i * 7 + i / 13) % 26);
+  }
+  return text;
+}
+
+struct Received {
+  std::string payload;
+  int64_t messageId = 0;
+  uint8_t flags = 0;
+};
+
+Received readOne(Reader &reader) {
+  Received received;
+  auto buffer = reader.read(&received.messageId, &received.flags);
+  received.payload = std::string(buffer.view());
+  return received;
+}
+} // namespace
+
+TEST(FrameStream, SmallFramesKeepOrder) {
+  SocketPair sockets;
+  Compressor compressor;
+  Writer writer(*sockets.writer, [](const std::exception &) {});
+  Reader reader(*sockets.reader, compressor);
+  for (int i = 1; i <= 100; i++) {
+    writer.push(std::to_string(i), i, makeFlags(Codec::MsgPack));
+  }
+  for (int i = 1; i <= 100; i++) {
+    auto received = readOne(reader);
+    EXPECT_EQ(received.messageId, i);
+    EXPECT_EQ(received.payload, std::to_string(i));
+    EXPECT_EQ(codecOf(received.flags), Codec::MsgPack);
+  }
+}
+
+TEST(FrameStream, BulkMessageIsChunkedAndReassembled) {
+  SocketPair sockets;
+  Compressor compressor;
+  Writer writer(*sockets.writer, [](const std::exception &) {});
+  Reader reader(*sockets.reader, compressor);
+  const auto large = patterned(kChunkSize * 5 + 123);
+  writer.push(std::string(large), 1, makeFlags(Codec::Json) | kAttachmentFlag);
+  auto received = readOne(reader);
+  EXPECT_EQ(received.messageId, 1);
+  EXPECT_EQ(received.payload, large);
+  EXPECT_FALSE(received.flags & kChunkFlag);
+  EXPECT_TRUE(hasAttachments(received.flags));
+}
+
+TEST(FrameStream, LaterFramesWaitBehindBulk) {
+  SocketPair sockets;
+  Compressor compressor;
+  Writer writer(*sockets.writer, [](const std::exception &) {});
+  Reader reader(*sockets.reader, compressor);
+  // 大的异步batch之后的同步调用不能先到
+  std::vector<std::string> sent;
+  for (int i = 1; i <= 6; i++) {
+    sent.push_back(i % 2 ? patterned(kChunkSize * 3 + i) : std::to_string(i));
+    writer.push(std::string(sent.back()), i, makeFlags(Codec::Json));
+  }
+  for (int i = 1; i <= 6; i++) {
+    auto received = readOne(reader);
+    ASSERT_EQ(received.messageId, i);
+    EXPECT_EQ(received.payload, sent[i - 1]);
+  }
+}
+
+TEST(FrameStream, WholeFrameWithoutChunking) {
+  SocketPair sockets;
+  Compressor compressor;
+  Writer writer(*sockets.writer, [](const std::exception &) {}, false);
+  Reader reader(*sockets.reader, compressor);
+  const auto large = patterned(kChunkSize * 2);
+  writer.push(std::string(large), 9, makeFlags(Codec::Cbor));
+  auto received = readOne(reader);
+  EXPECT_EQ(received.messageId, 9);
+  EXPECT_EQ(received.payload, large);
+}
+
+TEST(FrameStream, CompressedFrameIsInflated) {
+  SocketPair sockets;
+  Compressor sender(1024), receiver;
+  sender.setEnabled(true);
+  auto message = std::string(8192, 'x');
+  uint8_t flags = makeFlags(Codec::Json);
+  sender.deflate(message, flags);
+  ASSERT_TRUE(flags & kCompressedFlag);
+  sockets.writeFrame(message, 3, flags);
+
+  Reader reader(*sockets.reader, receiver);
+  auto received = readOne(reader);
+  EXPECT_EQ(received.payload, std::string(8192, 'x'));
+  EXPECT_FALSE(received.flags & kCompressedFlag);
+}
+
+TEST(FrameStream, StreamConsumerTakesChunks) {
+  struct Collector : Reader::StreamConsumer {
+    std::string data;
+    uint64_t total = 0;
+    bool ended = false;
+    bool begin(int64_t, uint8_t, uint64_t value) override {
+      total = value;
+      return true;
+    }
+    void append(const char *bytes, std::size_t length) override {
+      data.append(bytes, length);
+    }
+    void end() override {
+      ended = true;
+    }
+  };
+  SocketPair sockets;
+  Compressor compressor;
+  Reader reader(*sockets.reader, compressor);
+  auto collector = std::make_shared<Collector>();
+  reader.setStreamConsumer(collector);
+  sockets.writeChunk("hello ", 4, kChunkFirst, 11);
+  sockets.writeChunk("world", 4, kChunkLast, 11);
+  sockets.writeFrame("next", 5, makeFlags(Codec::Json));
+  // 被消费者接管的消息不再由read返回
+  auto received = readOne(reader);
+  EXPECT_EQ(received.messageId, 5);
+  EXPECT_EQ(collector->data, "hello world");
+  EXPECT_EQ(collector->total, 11u);
+  EXPECT_TRUE(collector->ended);
+}
+
+TEST(FrameStream, TruncatedFrame) {
+  SocketPair sockets;
+  Compressor compressor;
+  Reader reader(*sockets.reader, compressor);
+  std::array<uint8_t, kHeaderSize> header{};
+  encodeHeader(header.data(), 100, 1, makeFlags(Codec::Json));
+  boost::asio::write(*sockets.writer, boost::asio::buffer(header));
+  boost::asio::write(*sockets.writer, boost::asio::buffer(std::string(10, 'x')));
+  sockets.writer->close();
+  EXPECT_THROW(readOne(reader), boost::system::system_error);
+}
+
+TEST(FrameStream, ChunkWithoutFirst) {
+  SocketPair sockets;
+  Compressor compressor;
+  Reader reader(*sockets.reader, compressor);
+  sockets.writeChunk("tail", 7, kChunkLast, 8);
+  EXPECT_THROW(readOne(reader), std::runtime_error);
+}
+
+TEST(FrameStream, ChunkFromOtherMessage) {
+  SocketPair sockets;
+  Compressor compressor;
+  Reader reader(*sockets.reader, compressor);
+  sockets.writeChunk("abcd", 7, kChunkFirst, 8);
+  sockets.writeChunk("efgh", 8, kChunkLast, 8);
+  EXPECT_THROW(readOne(reader), std::runtime_error);
+}
+
+TEST(FrameStream, ChunkExceedsTotal) {
+  SocketPair sockets;
+  Compressor compressor;
+  Reader reader(*sockets.reader, compressor);
+  sockets.writeChunk("abcd", 7, kChunkFirst, 6);
+  sockets.writeChunk("efgh", 7, kChunkLast, 6);
+  EXPECT_THROW(readOne(reader), std::runtime_error);
+}
+
+TEST(FrameStream, IncompleteChunkedMessage) {
+  SocketPair sockets;
+  Compressor compressor;
+  Reader reader(*sockets.reader, compressor);
+  sockets.writeChunk("abcd", 7, kChunkFirst | kChunkLast, 8);
+  EXPECT_THROW(readOne(reader), std::runtime_error);
+}
+
+TEST(FrameStream, ChunkFrameTooShort) {
+  SocketPair sockets;
+  Compressor compressor;
+  Reader reader(*sockets.reader, compressor);
+  sockets.writeFrame("x", 7, makeFlags(Codec::Json) | kChunkFlag);
+  EXPECT_THROW(readOne(reader), std::runtime_error);
+}
+
+TEST(FrameStream, WriterRejectsAfterStop) {
+  SocketPair sockets;
+  Writer writer(*sockets.writer, [](const std::exception &) {});
+  writer.stop();
+  EXPECT_THROW(writer.push("late", 1, 0), std::runtime_error);
+}
+} // namespace Frame
+#endif
@@ -29,8 +29,8 @@ const hookCallbackArgument = (arg: any) => {
         const name = arg?.constructor?.name
         // 特定实例，转换为自定义对象
         if (clazzList.includes(name)) {
-            const { getInstanceId, setInstance } = useInstanceManage()
-            const instanceId = getInstanceId(arg) || setInstance(arg);
+            const { exportInstance } = useInstanceManage()
+            const instanceId = exportInstance(arg);
             arg = {
                 instanceId: instanceId,
                 instanceType: name,
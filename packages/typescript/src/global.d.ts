@@ -2,7 +2,7 @@ import { Controller } from "./server/controller"
 
 declare global {
     var sendMessageSync: (message: string) => string
-    var send: (message: string, messageId?: number) => void
+    var send: (message: string | object, messageId?: number) => void
     var blockUntilNextMessage: () => void
     var controller: Controller
     var clazzSet: Set<string>
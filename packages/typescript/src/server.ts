@@ -2,6 +2,8 @@ import { useLogger } from "./common/log"
 import { registerDefaultClazz, useInstanceManage, useObjectManage } from "./server/object-manage"
 import { hookArgument, hookResult } from "./common/hook-argument"
 import { Controller } from "./server/controller"
+import { usePropertyCache } from "./server/property-cache"
+import { RequestType, useMethodTable } from "./server/method-table"
 const log = useLogger('Server')
 try {
   log.info('Hi rpc server!')
@@ -22,150 +24,115 @@ try {
   window = g
   registerDefaultClazz(g)
   const port = 3001
-  server.start('127.0.0.1', port)
-  server.setMessageCallback((message: string, messageId: number) => {
-    const reply = (payload: any) => {
-      global.send(JSON.stringify(payload), messageId)
+  // unix:/path/to/skyline.sock 使用Unix domain socket，否则为TCP
+  const address = process.env.SKYLINE_SERVER_ADDRESS || '127.0.0.1'
+  server.start(address, port)
+  type Request = {
+    // 未压缩的请求使用字符串字段，压缩后为编号：t类型，c类名，m方法名
+    type?: RequestType
+    t?: number
+    clazz?: string
+    c?: number
+    action?: string
+    m?: number
+    data: {
+      instanceId?: number
+      clazz?: string
+      callbackId?: string
+      asyncCallback?: boolean
+      params?: any[]
+      propertyAction?: 'set' | 'get'
+      // 压缩后的propertyAction：1为set，0为get
+      p?: number
+      // dynamicProperties：一次读取的属性名
+      properties?: string[]
+      // 流水线请求：结果暂存在此编号下，供后续请求引用
+      answerId?: number
+      // 客户端分配的实例id，结果直接登记在此id下，不回复
+      bindId?: number
+      // intern：新分配的类名/方法名编号
+      base?: number
+      names?: string[]
+      // releaseInstances：[实例id, 客户端收到的次数]
+      instances?: [number, number][]
     }
-    const req = JSON.parse(message) as {
-      type: 'constructor' | 'static' | 'dynamic' | 'dynamicProperty' | 'registerCallback'
-      clazz: string
-      action: string
-      data: {
-        instanceId?: number
-        clazz?: string
-        callbackId?: string
-        asyncCallback?: boolean
-        params?: any[]
-        propertyAction?: 'set' | 'get'
+  }
+  type Context = {
+    req: Request
+    // 编号已解析的类名/方法名
+    clazz: string
+    action: string
+    messageId: number
+    reply: (payload: any) => void
+  }
+  const handlers: Record<RequestType, (ctx: Context) => void> = {
+    constructor: ({ req, clazz: clazzName, messageId, reply }) => {
+      // 构造对象请求
+      const { getClazz } = useObjectManage()
+      const clazz = getClazz(clazzName)
+      if (!clazz) {
+        log.error('Class not found', clazzName)
+        reply({ error: 'Class not found' })
+        return
       }
-    }
-    if (req.action === 'disconnected') {
-      log.error('disconnected')
-      return
-    }
-    try {
-      log.debug(`Received message => ${message}`);
-      if (req.type === 'constructor') {
-        // 构造对象请求
-        const { getClazz } = useObjectManage()
-        const clazz = getClazz(req.clazz)
-        if (!clazz) {
-          log.error('Class not found', req.clazz)
-          reply({ error: 'Class not found' })
-          return
-        }
-        // 实例化对象
-        const { setInstance } = useInstanceManage()
-        const params = req.data.params || []
-        const instanceId = setInstance(new clazz(...params))
-        log.debug('constructor end', req.clazz, instanceId)
+      // 实例化对象
+      const { setInstance, bindInstance } = useInstanceManage()
+      const params = req.data.params || []
+      const instance = new clazz(...params)
+      const instanceId = req.data.bindId ? bindInstance(req.data.bindId, instance) : setInstance(instance)
+      log.debug('constructor end', clazzName, instanceId)
+      if (messageId > 0) {
         reply({ result: { instanceId: instanceId } })
       }
-      else if (req.type == 'static') {
-        // 静态对象调用请求
-        const { getClazz } = useObjectManage()
-        const clazz = getClazz(req.clazz)
-        if (!clazz) {
-          reply({ error: 'Class not found' })
-          return
-        }
-        if (typeof clazz[req.action] === 'function') {
-          const params = req.data.params || []
-          hookArgument(req.action, params)
-          log.debug('static call', req.action, params)
-          let result = clazz[req.action](...params);
-          result = hookResult(`${req.action}_staticResult`, result)
-          log.debug("static call result", req.action, result);
-          reply({ result: { returnValue: result } });
-        } else if (typeof clazz[req.action] === 'object') {
-          let result = clazz[req.action]
-          result = hookResult(`${req.action}_staticResult`, result)
-          reply({ result: { returnValue: result } });
-        } else if (typeof clazz[req.action] !== 'undefined') {
-          const result = clazz[req.action]
-          reply({ result: { returnValue: result } });
-        } else {
-          log.error('Method not found or instance invalid', req.action, clazz[req.action])
-          reply({ error: 'Method not found or instance invalid' });
-        }
+    },
+    static: ({ req, clazz: clazzName, action, reply }) => {
+      // 静态对象调用请求
+      const { getClazz } = useObjectManage()
+      const clazz = getClazz(clazzName)
+      if (!clazz) {
+        reply({ error: 'Class not found' })
+        return
       }
-      else if (req.type == 'dynamic') {
-        // 动态对象调用请求
-        if (!req.data.instanceId) {
-          log.error('InstanceId not found')
-          reply({ error: 'InstanceId not found' })
-          return
-        }
-        const { getInstance } = useInstanceManage()
-        const instance = getInstance(req.data.instanceId);
-        if (instance && typeof instance[req.action] === 'function') {
-          const params = req.data.params || []
-          log.debug("dynamic call", instance, req.action, params);
-          hookArgument(req.action, params)
-          let result = instance[req.action](...params);
-          log.debug("dynamic call result", req.action, result);
-          result = hookResult(`${req.action}_dynamicResult`, result)
-          log.debug("dynamic call result hooked", req.action, result);
-
-          if (messageId > 0) {
-            reply({
-              result: {
-                returnValue: result,
-              },
-            });
-            if (req.action === 'matches' && result === true) {
-              console.info('matches:', instance, params, result)
-            } else if (req.action === 'appendCompiledStyleSheets') {
-              /**
-               * 阻塞当前线程，直到有新消息到来
-               * appendCompiledStyleSheets执行后，必须立即执行appendStyleSheets，否则崩溃。
-               * 
-               * 崩溃情况：
-               * 1. appendCompiledStyleSheets执行后，还未执行appendStyleSheets
-               * 2. 渲染线程开始新一轮渲染，此时样式表存在异常，由于官方程序未做异常处理，程序崩溃
-               * 
-               * 解决方法：
-               * 1. appendCompiledStyleSheets执行后，立即阻塞当前线程
-               * 2. 由于线程阻塞，渲染线程无法开始新一轮渲染
-               * 3. 收到appendStyleSheets，解除阻塞
-               * 4. 执行appendStyleSheets，此时优先级高于渲染线程
-               * 5. 渲染线程继续渲染
-               */
-              global.blockUntilNextMessage()
-            }
-          }
-        } else {
-          reply({ error: 'Method not found or instance invalid' });
-        }
+      if (typeof clazz[action] === 'function') {
+        const params = req.data.params || []
+        hookArgument(action, params)
+        log.debug('static call', action, params)
+        let result = clazz[action](...params);
+        result = hookResult(`${action}_staticResult`, result)
+        log.debug("static call result", action, result);
+        reply({ result: { returnValue: result } });
+      } else if (typeof clazz[action] === 'object') {
+        let result = clazz[action]
+        result = hookResult(`${action}_staticResult`, result)
+        reply({ result: { returnValue: result } });
+      } else if (typeof clazz[action] !== 'undefined') {
+        const result = clazz[action]
+        reply({ result: { returnValue: result } });
+      } else {
+        log.error('Method not found or instance invalid', action, clazz[action])
+        reply({ error: 'Method not found or instance invalid' });
       }
-      else if (req.type == 'dynamicProperty') {
-        // 动态对象调用请求
-        if (!req.data.instanceId) {
-          reply({ error: 'InstanceId not found' })
-          return
-        }
-        const { getInstance } = useInstanceManage()
-        const instance = getInstance(req.data.instanceId);
-        // 动态属性调用请求
-        const type = req.data.propertyAction
+    },
+    dynamic: ({ req, action, messageId, reply }) => {
+      // 动态对象调用请求
+      if (!req.data.instanceId) {
+        log.error('InstanceId not found')
+        reply({ error: 'InstanceId not found' })
+        return
+      }
+      const { getInstance } = useInstanceManage()
+      const instance = getInstance(req.data.instanceId);
+      if (instance && typeof instance[action] === 'function') {
         const params = req.data.params || []
-        log.debug("dynamic property", req.action, params);
-        hookArgument(req.action, params)
-        let result = undefined
-        if (type === 'set') {
-          // 设置属性
-          instance[req.action] = params[0]
-          log.debug("dynamic property set", req.action, params[0]);
+        log.debug("dynamic call", instance, action, params);
+        hookArgument(action, params)
+        let result = instance[action](...params);
+        log.debug("dynamic call result", action, result);
+        if (req.data.answerId) {
+          useInstanceManage().setAnswer(req.data.answerId, result)
         }
-        else if (type === 'get') {
-          // 获取属性
-          log.debug("dynamic property get", req.action, instance[req.action]);
-          result = instance[req.action];
-        }
-        log.debug("dynamic property result", req.action, result);
-        result = hookResult(`${req.action}_propertyResult`, result)
-        log.debug("dynamic property result hooked", req.action, result);
+        result = hookResult(`${action}_dynamicResult`, result)
+        log.debug("dynamic call result hooked", action, result);
 
         if (messageId > 0) {
           reply({
@@ -173,20 +140,184 @@ try {
               returnValue: result,
             },
           });
+          if (action === 'matches' && result === true) {
+            console.info('matches:', instance, params, result)
+          } else if (action === 'appendCompiledStyleSheets') {
+            /**
+             * 阻塞当前线程，直到有新消息到来
+             * appendCompiledStyleSheets执行后，必须立即执行appendStyleSheets，否则崩溃。
+             * 
+             * 崩溃情况：
+             * 1. appendCompiledStyleSheets执行后，还未执行appendStyleSheets
+             * 2. 渲染线程开始新一轮渲染，此时样式表存在异常，由于官方程序未做异常处理，程序崩溃
+             * 
+             * 解决方法：
+             * 1. appendCompiledStyleSheets执行后，立即阻塞当前线程
+             * 2. 由于线程阻塞，渲染线程无法开始新一轮渲染
+             * 3. 收到appendStyleSheets，解除阻塞
+             * 4. 执行appendStyleSheets，此时优先级高于渲染线程
+             * 5. 渲染线程继续渲染
+             */
+            global.blockUntilNextMessage()
+          }
+        }
+      } else {
+        reply({ error: 'Method not found or instance invalid' });
+      }
+    },
+    dynamicProperty: ({ req, action, messageId, reply }) => {
+      // 动态对象调用请求
+      if (!req.data.instanceId) {
+        reply({ error: 'InstanceId not found' })
+        return
+      }
+      const { getInstance } = useInstanceManage()
+      const instance = getInstance(req.data.instanceId);
+      // 动态属性调用请求
+      const type = typeof req.data.p === 'number' ? (req.data.p ? 'set' : 'get') : req.data.propertyAction
+      const params = req.data.params || []
+      log.debug("dynamic property", action, params);
+      hookArgument(action, params)
+      let result = undefined
+      let cacheable = false
+      if (type === 'set') {
+        // 设置属性
+        instance[action] = params[0]
+        log.debug("dynamic property set", action, params[0]);
+      }
+      else if (type === 'get') {
+        // 获取属性
+        log.debug("dynamic property get", action, instance[action]);
+        result = instance[action];
+        if (req.data.answerId) {
+          useInstanceManage().setAnswer(req.data.answerId, result)
+        }
+        cacheable = usePropertyCache().track(req.data.instanceId, instance, action, result)
+      }
+      log.debug("dynamic property result", action, result);
+      result = hookResult(`${action}_propertyResult`, result)
+      log.debug("dynamic property result hooked", action, result);
+
+      if (messageId > 0) {
+        reply({
+          result: {
+            returnValue: result,
+            // 客户端可以缓存，值变化时服务端发送invalidate
+            ...(cacheable ? { cacheable: true } : {}),
+          },
+        });
+      }
+    },
+    dynamicProperties: ({ req, reply }) => {
+      // 一次读取同一实例的多个属性
+      if (!req.data.instanceId) {
+        reply({ error: 'InstanceId not found' })
+        return
+      }
+      const { getInstance } = useInstanceManage()
+      const instance = getInstance(req.data.instanceId);
+      const values: Record<string, any> = {}
+      const cacheable: string[] = []
+      for (const property of req.data.properties || []) {
+        const value = instance[property]
+        if (usePropertyCache().track(req.data.instanceId, instance, property, value)) {
+          cacheable.push(property)
+        }
+        values[property] = hookResult(`${property}_propertyResult`, value)
+      }
+      log.debug("dynamic properties result", values);
+      reply({
+        result: {
+          returnValue: values,
+          cacheable,
+        },
+      });
+    },
+    releaseAnswer: ({ req }) => {
+      // 客户端已拿到真实实例id，不再引用暂存的结果
+      if (req.data.answerId) {
+        useInstanceManage().removeAnswer(req.data.answerId)
+      }
+    },
+    intern: ({ req }) => {
+      // 客户端在首次使用编号前发送定义
+      useMethodTable().define(req.data.base || 0, req.data.names || [])
+    },
+    releaseInstances: ({ req }) => {
+      // 客户端的代理已回收，收到次数抵消发出次数后删除
+      const { releaseInstance } = useInstanceManage()
+      for (const [instanceId, count] of req.data.instances || []) {
+        const instance = releaseInstance(instanceId, count)
+        if (instance !== undefined) {
+          usePropertyCache().untrack(instanceId, instance)
         }
       }
-      else {
+      log.debug('release instances', req.data.instances)
+    },
+  }
+  // 下标即请求类型编号
+  const handlerTable = useMethodTable().handlerTable(handlers)
+  const handleMessage = (message: string | object, messageId: number) => {
+    // JSON帧为字符串；二进制编码（msgpack/cbor）的帧已由native层解码为对象
+    const isBinary = typeof message !== 'string'
+    const req = (isBinary ? message : JSON.parse(message)) as Request
+    // 类型、类名、方法名可能是客户端分配的编号，直接查表，不写回请求
+    const { typeId, name } = useMethodTable()
+    const action = name(req.m, req.action)
+    const clazz = name(req.c, req.clazz)
+    const reply = (payload: any) => {
+      if (messageId <= 0) {
+        // 单向请求（异步调用、属性设置）没有等待方，只把错误异步报告给客户端
+        if (payload?.error !== undefined) {
+          global.send(JSON.stringify({
+            type: 'asyncError',
+            data: {
+              error: payload.error,
+              instanceId: req?.data?.instanceId,
+              action,
+            },
+          }))
+        }
+        return
+      }
+      // 本次请求引起的属性变化先通知客户端
+      usePropertyCache().flush()
+      // 按请求的编码回复
+      global.send(isBinary ? payload : JSON.stringify(payload), messageId)
+    }
+    if (action === 'disconnected') {
+      log.error('disconnected')
+      return
+    }
+    try {
+      log.debug('Received message =>', message);
+      const handler = handlerTable[typeId(req)]
+      if (!handler) {
         reply({ error: 'Request type not recognized' });
+        return
       }
+      handler({ req, clazz, action, messageId, reply })
     }
     catch (err: any) {
       log.error('Error:', err)
-      if (messageId > 0) {
-        reply({ error: err.message })
+      reply({ error: err.message })
+    }
+  }
+  server.setMessageCallback((message: string | object | object[], messageId: number) => {
+    // batch帧：客户端合并发送的异步调用，按顺序逐条处理，无需回复
+    if (Array.isArray(message)) {
+      for (const item of message) {
+        handleMessage(item, 0)
       }
+      usePropertyCache().flush()
+      return
+    }
+    handleMessage(message, messageId)
+    if (messageId <= 0) {
+      usePropertyCache().flush()
     }
   });
-  log.info(`✅ WebSocket Server listening on ws://localhost:${port}`);
+  log.info(`✅ Server listening on ${address.startsWith('unix:') ? address : `${address}:${port}`}`);
   log.info('end....')
 }
 catch (err) {
@@ -1,14 +1,43 @@
 import { useLogger } from "../common/log"
 
-const callbackMap = new Map<number, Function>()
+// tsconfig的lib为ES6，WeakRef/FinalizationRegistry由运行时提供
+const { WeakRef, FinalizationRegistry } = globalThis as any
+
+interface Registration {
+    callbackId: number
+    // 客户端发来该callbackId的次数，代理回收时一并归还
+    count: number
+}
+// 只弱引用代理：注册到的地方（如事件监听）不再持有时即可回收
+const callbackMap = new Map<number, { ref: { deref(): Function | undefined }, registration: Registration }>()
 const log = useLogger('Callback')
+
+const registry = new FinalizationRegistry((registration: Registration) => {
+    const { callbackId, count } = registration
+    if (callbackMap.get(callbackId)?.registration === registration) {
+        callbackMap.delete(callbackId)
+    }
+    // 通知客户端释放函数引用和ThreadSafeFunction
+    global.send(JSON.stringify({
+        type: 'unregister',
+        callbackId,
+        data: { count },
+    }))
+    log.debug('callback released', callbackId, count)
+})
+
 export const useCallback = () => ({
     getCallback: (callbackId: number, cb: Function) => {
-        if (!callbackMap.has(callbackId)) {
-            callbackMap.set(callbackId, cb)
-            log.debug('callback registered', callbackId)
-            return cb
+        const entry = callbackMap.get(callbackId)
+        const existing = entry?.ref.deref()
+        if (entry && existing) {
+            entry.registration.count++
+            return existing
         }
-        return callbackMap.get(callbackId)
+        const registration: Registration = { callbackId, count: 1 }
+        callbackMap.set(callbackId, { ref: new WeakRef(cb), registration })
+        registry.register(cb, registration)
+        log.debug('callback registered', callbackId)
+        return cb
     },
-})
\ No newline at end of file
+})
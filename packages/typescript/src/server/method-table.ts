@@ -0,0 +1,53 @@
+import { useLogger } from "../common/log"
+
+const log = useLogger('MethodTable')
+
+/**
+ * 请求类型的编号，下标即编号，与客户端client/method_table.cc一致
+ */
+const requestTypes = [
+    'constructor',
+    'static',
+    'dynamic',
+    'dynamicProperty',
+    'dynamicProperties',
+    'releaseAnswer',
+    'intern',
+    'releaseInstances',
+] as const
+
+// 客户端按连接分配的类名/方法名编号
+const names: string[] = []
+
+export type RequestType = typeof requestTypes[number]
+
+export const useMethodTable = () => ({
+    /**
+     * 登记客户端新分配的编号，编号从base开始连续
+     */
+    define: (base: number, list: string[]) => {
+        for (let i = 0; i < list.length; i++) {
+            names[base + i] = list[i]
+        }
+        log.debug('define', base, list)
+    },
+    /**
+     * 按类型编号排列的处理函数表，下标即编号
+     */
+    handlerTable: <H>(handlers: Record<RequestType, H>): H[] => requestTypes.map(type => handlers[type]),
+    /**
+     * 请求类型的编号；未压缩的请求按类型名查找，未知类型返回-1
+     */
+    typeId: (req: { t?: number, type?: string }): number => {
+        if (typeof req?.t === 'number') {
+            return req.t
+        }
+        return requestTypes.indexOf(req?.type as RequestType)
+    },
+    /**
+     * 编号对应的类名/方法名；未压缩的请求直接使用原字段
+     */
+    name: (id: number | undefined, fallback: string | undefined): string => {
+        return (typeof id === 'number' ? names[id] : fallback) as string
+    },
+})
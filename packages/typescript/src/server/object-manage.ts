@@ -31,18 +31,57 @@ export const registerDefaultClazz = (g: any) => {
 }
 
 const instanceMap = new Map<number, any>();
+// 流水线请求暂存的结果，客户端以 -answerId 作为实例id引用
+const answerMap = new Map<number, any>();
 const instanceObjectIdMap = new WeakMap<object, number>();
 const instancePrimitiveIdMap = new Map<any, number>();
 globalThis.instanceMap = instanceMap;
 let instanceId = 1;
+// 实例引用发给客户端的次数，客户端回收代理后归还收到的次数，归零才删除
+const exportCounts = new Map<number, number>();
+
+/**
+ * 通知客户端这些实例已删除，客户端丢弃对应的代理缓存
+ */
+const notifyDropped = (instanceIds: number[]) => {
+    if (instanceIds.length === 0) return
+    global.send(JSON.stringify({
+        type: 'dropInstances',
+        data: { instanceIds },
+    }))
+}
 
 const isWeakMapKey = (value: any): value is object => {
     return (typeof value === 'object' && value !== null) || typeof value === 'function'
 }
 export const useInstanceManage = () => ({
     getInstance: (instanceId: number) => {
+        if (instanceId < 0) {
+            return answerMap.get(-instanceId)
+        }
         return instanceMap.get(instanceId)
     },
+    /**
+     * 以客户端分配的id登记实例（客户端id从2^40开始，与instanceId自增的范围不重叠）
+     */
+    bindInstance: (id: number, instance: any) => {
+        instanceMap.set(id, instance)
+        exportCounts.set(id, 1)
+        if (isWeakMapKey(instance)) {
+            if (!instanceObjectIdMap.has(instance)) {
+                instanceObjectIdMap.set(instance, id)
+            }
+        } else if (!instancePrimitiveIdMap.has(instance)) {
+            instancePrimitiveIdMap.set(instance, id)
+        }
+        return id
+    },
+    setAnswer: (answerId: number, result: any) => {
+        answerMap.set(answerId, result)
+    },
+    removeAnswer: (answerId: number) => {
+        answerMap.delete(answerId)
+    },
     getInstanceId: (instance: any) => {
         if (isWeakMapKey(instance)) {
             return instanceObjectIdMap.get(instance) ?? null
@@ -52,6 +91,7 @@ export const useInstanceManage = () => ({
     setInstance: (instance: any) => {
         const id = instanceId++
         instanceMap.set(id, instance)
+        exportCounts.set(id, 1)
         if (isWeakMapKey(instance)) {
             if (!instanceObjectIdMap.has(instance)) {
                 instanceObjectIdMap.set(instance, id)
@@ -61,8 +101,34 @@ export const useInstanceManage = () => ({
         }
         return id
     },
+    /**
+     * 再次把已登记的实例发给客户端，沿用原来的id
+     */
+    exportInstance: (instance: any) => {
+        const manage = useInstanceManage()
+        const id = manage.getInstanceId(instance)
+        if (id === null || !instanceMap.has(id)) {
+            return manage.setInstance(instance)
+        }
+        exportCounts.set(id, (exportCounts.get(id) ?? 0) + 1)
+        return id
+    },
+    /**
+     * 客户端回收了代理，count为它收到该实例的次数；之后没有再发出过时删除，返回被删除的实例
+     */
+    releaseInstance: (instanceId: number, count: number) => {
+        const remaining = (exportCounts.get(instanceId) ?? 0) - count
+        if (remaining > 0) {
+            exportCounts.set(instanceId, remaining)
+            return undefined
+        }
+        const instance = instanceMap.get(instanceId)
+        useInstanceManage().removeInstance(instanceId)
+        return instance
+    },
     removeInstance: (instanceId: number) => {
         const instance = instanceMap.get(instanceId)
+        exportCounts.delete(instanceId)
         if (!instanceMap.delete(instanceId)) {
             return
         }
@@ -103,9 +169,12 @@ export const useInstanceManage = () => ({
         }
     },
     removeInstanceOfType: (type: string) => {
+        const removed: number[] = []
         for (const [id, instance] of instanceMap.entries()) {
             if (instance?.constructor?.name === type) {
                 instanceMap.delete(id)
+                exportCounts.delete(id)
+                removed.push(id)
                 if (isWeakMapKey(instance)) {
                     const mappedId = instanceObjectIdMap.get(instance)
                     if (mappedId === id) {
@@ -119,9 +188,13 @@ export const useInstanceManage = () => ({
                 }
             }
         }
+        notifyDropped(removed)
     },
     clearInstance: () => {
+        notifyDropped(Array.from(instanceMap.keys()))
         instanceMap.clear()
+        exportCounts.clear()
+        answerMap.clear()
         instancePrimitiveIdMap.clear()
     },
 })
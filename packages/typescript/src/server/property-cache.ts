@@ -0,0 +1,111 @@
+import { useLogger } from "../common/log"
+
+const log = useLogger('PropertyCache')
+
+/**
+ * 允许客户端缓存的属性，按类名登记
+ *
+ * 只登记能在服务端感知变化的属性：DOM属性通过MutationObserver，webview.src额外监听导航
+ */
+const cacheableProperties: Record<string, string[]> = {
+    CSSStyleDeclaration: ['display', 'pointerEvents'],
+    ChromeWebViewElement: ['src'],
+    Event: ['type', 'messageText', 'messageType'],
+}
+// 属性创建后不变，不需要监听
+const immutableClasses = new Set(['Event'])
+
+// 实例 -> 客户端可能缓存了它属性的实例id
+const watchedIds = new WeakMap<object, Set<number>>()
+// 实例 -> 监听它的MutationObserver，客户端不再引用时断开
+const observers = new Map<object, MutationObserver>()
+// 已监听导航的webview，重新监听时不重复添加
+const navigationWatched = new WeakSet<object>()
+// style对象 -> 所属元素，style读取时登记
+const styleOwner = new WeakMap<object, Element>()
+
+const invalidate = (instance: object, property?: string) => {
+    const ids = watchedIds.get(instance)
+    if (!ids) return
+    for (const instanceId of ids) {
+        global.send(JSON.stringify({
+            type: 'invalidate',
+            data: { instanceId, property },
+        }))
+    }
+    log.debug('invalidate', property, ids)
+}
+
+/**
+ * 立即处理尚未回调的变化记录
+ *
+ * MutationObserver在微任务中回调，晚于本次请求的回复；回复前调用，保证客户端先收到invalidate
+ */
+const flush = () => {
+    for (const [instance, observer] of observers) {
+        if (observer.takeRecords().length > 0) {
+            invalidate(instance)
+        }
+    }
+}
+
+/**
+ * 监听实例的变化，无法监听时返回false
+ */
+const observe = (instance: any) => {
+    if (observers.has(instance)) return true
+    const element: Element | undefined = instance instanceof Element ? instance : styleOwner.get(instance)
+    if (!element) return false
+    const observer = new MutationObserver(() => invalidate(instance))
+    observers.set(instance, observer)
+    observer.observe(element, {
+        attributes: true,
+        attributeFilter: element === instance ? undefined : ['style', 'class'],
+    })
+    if (element === instance && element.tagName === 'WEBVIEW' && !navigationWatched.has(instance)) {
+        navigationWatched.add(instance)
+        element.addEventListener('loadcommit', () => invalidate(instance, 'src'))
+    }
+    return true
+}
+
+export const usePropertyCache = () => ({
+    /**
+     * 读取属性后调用，返回客户端是否可以缓存该值
+     */
+    track: (instanceId: number, instance: any, property: string, value: any) => {
+        if (property === 'style' && instance instanceof Element && value) {
+            styleOwner.set(value, instance)
+        }
+        const name = instance?.constructor?.name
+        if (instanceId <= 0 || !cacheableProperties[name]?.includes(property)) {
+            return false
+        }
+        if (!immutableClasses.has(name) && !observe(instance)) {
+            return false
+        }
+        let ids = watchedIds.get(instance)
+        if (!ids) {
+            ids = new Set()
+            watchedIds.set(instance, ids)
+        }
+        ids.add(instanceId)
+        return true
+    },
+    invalidate,
+    flush,
+    /**
+     * 客户端释放了实例id，不再为它发送invalidate
+     */
+    untrack: (instanceId: number, instance: any) => {
+        if (instance === null || (typeof instance !== 'object' && typeof instance !== 'function')) return
+        const ids = watchedIds.get(instance)
+        if (!ids) return
+        ids.delete(instanceId)
+        if (ids.size === 0) {
+            watchedIds.delete(instance)
+            observers.get(instance)?.disconnect()
+            observers.delete(instance)
+        }
+    },
+})
@@ -0,0 +1,31 @@
+import { describe, it, expect, beforeAll } from 'vitest'
+import path from 'path'
+
+const clientNode = process.env['SKYLINE_DEV_PATH']
+    ? `${process.env['SKYLINE_DEV_PATH']}/skyline.node`
+    : path.resolve(__dirname, "../packages/native/build/skyline.node")
+const skylineClient = require(clientNode);
+
+// 服务端按请求的编码直接回复对象，实例引用需要带着instanceType回到客户端
+describe('msgpack 编码', () => {
+    beforeAll(() => {
+        skylineClient.Controller.connect('127.0.0.1', 3001, { codec: 'msgpack' })
+    })
+    it('返回的实例引用还原为代理', () => {
+        const controller = new skylineClient.Controller(console.error)
+        const wv = controller.webview
+        const request = wv.request
+        expect(request.onAuthRequired.constructor.name).toBe('WebRequestEvent')
+        expect(request.onMessage.constructor.name).toBe('RequestMessageEvent')
+        expect(request.onRequest.constructor.name).toBe('RequestRule')
+    })
+    it('代理可以继续调用', () => {
+        const controller = new skylineClient.Controller(console.error)
+        const onAuthRequired = controller.webview.request.onAuthRequired
+        const listener = () => ({ cancel: true })
+        onAuthRequired.addListener(listener, { urls: ['<all_urls>'] })
+        expect(onAuthRequired.hasListener(listener)).toBe(true)
+        onAuthRequired.removeListener(listener)
+        expect(onAuthRequired.hasListener(listener)).toBe(false)
+    })
+})
@@ -0,0 +1,49 @@
+import { describe, it, expect } from 'vitest'
+import path from 'path'
+
+const clientNode = process.env['SKYLINE_DEV_PATH']
+    ? `${process.env['SKYLINE_DEV_PATH']}/skyline.node`
+    : path.resolve(__dirname, "../packages/native/build/skyline.node")
+const skylineClient = require(clientNode);
+
+// 同步调用的参数直接编码，结果必须与先转换为json再编码一致；不需要连接服务端
+const values: Record<string, unknown> = {
+    '字符串': ['', 'a'.repeat(40), '引号"与\\反斜杠\n', '中文'],
+    '数字': [0, -1, 1.5, 1e300, -0.1, 2 ** 40, -(2 ** 40), Infinity],
+    '布尔与空值': [true, false, null, undefined],
+    '嵌套': { a: { b: [1, { c: 'd' }] }, empty: {}, list: [] },
+    '空键被忽略': { '': 1, k: 2 },
+    '实例引用': { instanceId: 5, instanceType: 'WebRequestEvent', other: 1 },
+    '二进制': {
+        buffer: Buffer.from('buffer'),
+        arrayBuffer: new Uint8Array([1, 2, 3, 4]).buffer,
+        uint16: new Uint16Array([1, 65535]),
+        float64: new Float64Array([1.5, -2]),
+        view: new Uint8Array(new Uint8Array([9, 8, 7, 6, 5]).buffer, 1, 3),
+        empty: new Uint8Array(0),
+    },
+    '与附件占位对象同名的键': {
+        user: { $attachment: 0, subtype: 1 },
+        $$double: 1,
+        blob: Buffer.from('blob'),
+    },
+    '大数组': Array.from({ length: 70000 }, (_, i) => i),
+}
+
+for (const codec of ['json', 'msgpack']) {
+    describe(`${codec} 直接编码`, () => {
+        for (const [name, value] of Object.entries(values)) {
+            it(name, () => {
+                const result = skylineClient.Controller.checkEncoding(value, codec)
+                expect(result.equal).toBe(true)
+                expect(result.direct).toEqual(result.reference)
+            })
+        }
+    })
+}
+
+describe('cbor 直接编码', () => {
+    it('不支持', () => {
+        expect(() => skylineClient.Controller.checkEncoding(1, 'cbor')).toThrow()
+    })
+})
@@ -16,6 +16,23 @@ describe('基础数据获取', () => {
         expect(controller.webview).toBeDefined()
     })
 
+    it('解析前重复读取返回同一个代理', () => {
+        const controller = new skylineClient.Controller(console.error)
+        const wv = controller.webview
+        expect(controller.webview).toBe(wv)
+        expect(wv.style).toBe(wv.style)
+    })
+
+    it('解析后重复读取仍返回同一个代理', () => {
+        const controller = new skylineClient.Controller(console.error)
+        const wv = controller.webview
+        const style = wv.style
+        // 同步调用等待回复，流水线读取在此之前已解析
+        expect(wv.src).toBeDefined()
+        expect(controller.webview).toBe(wv)
+        expect(wv.style).toBe(style)
+    })
+
     it('Webview src 可用', () => {
         const controller = new skylineClient.Controller(console.error)
         expect(controller.webview.src).toBeDefined()
@@ -55,6 +72,41 @@ describe('简单数据修改', () => {
         expect(wv.style.pointerEvents).toBe('none')
     })
 
+    it('style同一帧内多次修改', async () => {
+        const controller = new skylineClient.Controller(console.error)
+        const wv = controller.webview
+        for (let i = 0; i < 10; i++) {
+            wv.style.display = i % 2 ? 'block' : 'none'
+        }
+        expect(wv.style.display).toBe('block')
+        // 等待按帧合并的写入发出后再读取
+        await new Promise(resolve => setTimeout(resolve, 50))
+        expect(wv.style.display).toBe('block')
+    })
+
+    it('style写入无效值后读取服务端的值', () => {
+        const controller = new skylineClient.Controller(console.error)
+        const wv = controller.webview
+        wv.style.display = 'block'
+        expect(wv.style.display).toBe('block')
+        // 浏览器忽略无效的样式值，客户端不缓存写入的值
+        wv.style.display = 'not-a-display'
+        expect(wv.style.display).toBe('block')
+    })
+
+    it('style方法调用后缓存的属性失效', async () => {
+        const controller = new skylineClient.Controller(console.error)
+        const wv = controller.webview
+        wv.style.display = 'block'
+        await new Promise(resolve => setTimeout(resolve, 50))
+        // 读取后客户端缓存该值
+        expect(wv.style.display).toBe('block')
+        wv.style.setText('display:none')
+        expect(wv.style.display).toBe('none')
+        wv.style.setTextAsync('display:flex')
+        expect(wv.style.display).toBe('flex')
+    })
+
 })
 
 describe('请求拦截', () => {
@@ -0,0 +1,55 @@
+// 传输层往返延迟对比
+// 用法: node tools/benchmark-transport.js 127.0.0.1 unix:/tmp/skyline.sock shm:unix:/tmp/skyline.sock
+// shm: 前缀表示握手后升级到共享内存
+// 每个地址需有对应的服务端在监听（SKYLINE_SERVER_ADDRESS）
+const path = require('path')
+const { execFileSync } = require('child_process')
+
+const clientNode = process.env['SKYLINE_DEV_PATH']
+    ? `${process.env['SKYLINE_DEV_PATH']}/skyline.node`
+    : path.resolve(__dirname, '../packages/native/build/skyline.node')
+const iterations = Number(process.env['ITERATIONS'] || 10000)
+
+function run(address) {
+    // 每个地址单独一个进程，连接是进程级单例
+    const skylineClient = require(clientNode)
+    if (address.startsWith('shm:')) {
+        skylineClient.Controller.connect(address.slice(4), 3001, { sharedMemory: true })
+    } else {
+        skylineClient.Controller.connect(address)
+    }
+    const controller = new skylineClient.Controller(console.error)
+    const webview = controller.webview
+    const samples = []
+    for (let i = 0; i < iterations; i++) {
+        const start = process.hrtime.bigint()
+        // 同步调用阻塞到服务端回复；getAttribute不记录结果，每次都是一次完整往返
+        webview.getAttribute('src')
+        samples.push(Number(process.hrtime.bigint() - start) / 1000)
+    }
+    samples.sort((a, b) => a - b)
+    const pick = (p) => samples[Math.min(samples.length - 1, Math.floor(samples.length * p))]
+    const avg = samples.reduce((a, b) => a + b, 0) / samples.length
+    console.log(JSON.stringify({ address, avg, p50: pick(0.5), p99: pick(0.99) }))
+    process.exit(0)
+}
+
+if (process.argv[2] === '--child') {
+    run(process.argv[3])
+} else {
+    const addresses = process.argv.slice(2)
+    if (addresses.length === 0) {
+        addresses.push('127.0.0.1')
+    }
+    const rows = addresses.map((address) => {
+        const out = execFileSync(process.execPath, [__filename, '--child', address], { encoding: 'utf8' })
+        return JSON.parse(out.trim().split('\n').pop())
+    })
+    console.log(`iterations: ${iterations}`)
+    console.table(rows.map((r) => ({
+        address: r.address,
+        'avg(us)': r.avg.toFixed(1),
+        'p50(us)': r.p50.toFixed(1),
+        'p99(us)': r.p99.toFixed(1),
+    })))
+}